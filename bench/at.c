@@ -0,0 +1,84 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Array element access on root array of numbers (TD_NUMBERS): random and strided (step 97)
+ * indexes by v2_json_at() against walk of child/next list - what callers did before,
+ * 1000 times less walks. Every element has to be the same.
+ *
+ * Usage: at [MB (4)] [accesses (1000000)]
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "doc.h"
+#include "v2_jsmn.h"
+
+/* ========================================================================= */
+static json_lst_t *ta_walk(json_lst_t *in_arr, size_t in_idx) {
+    json_lst_t *json=in_arr->child;
+
+    for(; json && in_idx; json=json->next) in_idx--;
+    return(json);
+}
+/* ========================================================================= */
+// Nanoseconds per access, *p_bad - wrong elements
+static double ta_run(json_box_t *in_box, json_lst_t *in_arr, size_t in_len, size_t in_num, int is_walk, int is_random, size_t *p_bad) {
+    unsigned int seed=1;
+    json_lst_t *json=NULL;
+    double t=td_now();
+    size_t x=0;
+    size_t i=0;
+
+    for(i=0; i<in_num; i++) {
+	x=is_random ? td_rand(&seed) % in_len : (i*97) % in_len;
+	json=is_walk ? ta_walk(in_arr, x) : v2_json_at(in_box, in_arr, x);
+	if(!json || (is_walk && json != v2_json_at(in_box, in_arr, x))) (*p_bad)++;
+    }
+    return((td_now()-t)/in_num*1e9);
+}
+/* ========================================================================= */
+int main(int argc, char *argv[]) {
+    size_t mb=(argc > 1) ? (size_t)atoi(argv[1]) : 4;
+    size_t num=(argc > 2) ? (size_t)atol(argv[2]) : 1000000;
+    v2_jsmn_t jsmn;
+    json_lst_t *arr=NULL;
+    char *js=NULL;
+    size_t len=0;
+    size_t bad=0;
+
+    memset(&jsmn, 0, sizeof(jsmn));
+    if(!(js=td_doc(TD_NUMBERS, 1, mb << 20, &len))) return(1);
+    v2_wrbuf_new(&jsmn.b);
+    v2_wrbuf_write(jsmn.b, js, 1, len);
+    free(js);
+    if(v2_jsmn_parse(&jsmn) || !jsmn.box || !(arr=jsmn.box->lst) || arr->js_type != JS_ARRAY) return(1);
+    len=v2_json_len(jsmn.box, arr);
+
+    printf("at: array of %zu elements\n", len);
+    printf("  random   v2_json_at() %8.1f ns, walk %10.1f ns\n", ta_run(jsmn.box, arr, len, num, 0, 1, &bad), ta_run(jsmn.box, arr, len, num/1000+1, 1, 1, &bad));
+    printf("  stride97 v2_json_at() %8.1f ns, walk %10.1f ns\n", ta_run(jsmn.box, arr, len, num, 0, 0, &bad), ta_run(jsmn.box, arr, len, num/1000+1, 1, 0, &bad));
+    if(bad) printf("  %zu wrong elements\n", bad);
+
+    v2_json_free_box(jsmn.box);
+    free(jsmn.box);
+    v2_jsmn_init(&jsmn);
+    v2_wrbuf_free(&jsmn.b);
+    return(bad ? 1 : 0);
+}
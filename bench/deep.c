@@ -0,0 +1,120 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Builder, printer and destructor on deep and wide shapes of about the same nodes:
+ *   - deep: N levels of nested arrays and objects (TD_DEEP)
+ *   - wide: root array of N short arrays and objects
+ * Milliseconds of v2_jsmn_parse() (tape and sidx backends), v2_json_text() and v2_json_free_box().
+ * jsmn backend is left out: its jsmn_parse() is quadratic on both shapes (see bench/parse.c).
+ *
+ * Usage: deep [levels (1000000)]
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "doc.h"
+#include "v2_jsmn.h"
+
+static const char *td_back[]={"tape", "jsmn", "sidx"};
+
+/* ========================================================================= */
+// Root array of in_num "[1]" and "{\"a\": \"end\"}", malloc()-ed
+static char *td_wide(size_t in_num, size_t *p_len) {
+    wrbuf_t *b=NULL;
+    char *doc=NULL;
+    size_t x=0;
+
+    if(v2_wrbuf_new(&b)) return(NULL);
+    v2_wrbuf_putc(b, '[');
+    for(x=0; x<in_num; x++) {
+	if(x) v2_wrbuf_puts(b, ", ");
+	v2_wrbuf_puts(b, (x & 1)?"{\"a\": \"end\"}":"[1]");
+    }
+    v2_wrbuf_putc(b, ']');
+
+    doc=b->buf;
+    *p_len=b->cnt;
+    b->buf=NULL;
+    v2_wrbuf_free(&b);
+    return(doc);
+}
+/* ========================================================================= */
+static int td_run(const char *in_shape, const char *in_js, size_t in_len, int in_back) {
+    v2_jsmn_t jsmn;
+    double t_parse=0;
+    double t_text=0;
+    double t_free=0;
+    size_t out=0;
+    int rc=0;
+
+    memset(&jsmn, 0, sizeof(jsmn));
+    jsmn.backend=in_back;
+    v2_wrbuf_new(&jsmn.b);
+    v2_wrbuf_write(jsmn.b, (char *)in_js, 1, in_len);
+
+    t_parse=td_now();
+    rc=v2_jsmn_parse(&jsmn);
+    t_parse=td_now()-t_parse;
+    if(rc || !jsmn.box) {
+	printf("  %s %s: parse error %d\n", in_shape, td_back[in_back], rc);
+	return(1);
+    }
+
+    jsmn.box->ident=0;
+    v2_wrbuf_new(&jsmn.box->b);
+    t_text=td_now();
+    v2_json_text(jsmn.box);
+    t_text=td_now()-t_text;
+    out=jsmn.box->b->cnt;
+
+    t_free=td_now();
+    v2_json_free_box(jsmn.box);
+    t_free=td_now()-t_free;
+    free(jsmn.box);
+
+    v2_jsmn_init(&jsmn);
+    v2_wrbuf_free(&jsmn.b);
+
+    printf("  %-4s %s %8.1f ms parse %8.1f ms text (%zu bytes) %8.1f ms free\n", in_shape, td_back[in_back], t_parse*1e3, t_text*1e3, out, t_free*1e3);
+    return(0);
+}
+/* ========================================================================= */
+int main(int argc, char *argv[]) {
+    size_t num=(argc > 1) ? (size_t)atol(argv[1]) : 1000000;
+    char *deep=NULL;
+    char *wide=NULL;
+    size_t deep_len=0;
+    size_t wide_len=0;
+    int back=0;
+    int rc=0;
+
+    if(!(deep=td_doc(TD_DEEP, 1, num, &deep_len)) || !(wide=td_wide(num, &wide_len))) return(1);
+
+    printf("deep: %zu levels (%zu bytes), wide: %zu values (%zu bytes)\n", num, deep_len, num, wide_len);
+    for(back=V2_JSMN_BACK_TAPE; back<=V2_JSMN_BACK_SIDX; back++) {
+	if(back == V2_JSMN_BACK_JSMN) continue;
+	rc|=td_run("deep", deep, deep_len, back);
+	rc|=td_run("wide", wide, wide_len, back);
+    }
+
+    free(wide);
+    free(deep);
+    return(rc);
+}
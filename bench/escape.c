@@ -0,0 +1,126 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * String escaping: u8_escape() against v2_esc_level() at every stage level supported by CPU,
+ * V2_ESC_UTF8 and V2_ESC_QUOTES modes, on ASCII, Cyrillic and emoji heavy strings of 8..263 bytes.
+ * Input MB/s, best of 3. V2_ESC_UTF8 output has to be the same as u8_escape() one.
+ *
+ * Usage: escape [MB (4)]
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "doc.h"
+#include "v2_esc.h"
+#include "v2_sidx.h"
+#include "utf8.h"
+
+#define TE_RUNS 3
+
+static const char *te_ascii[]={"user", "name", " ", "12345", "sector", "-", "a\"q", "/path", "."};
+static const char *te_cyr[]={"\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82", " ", "\xd0\xbc\xd0\xb8\xd1\x80", ", ", "\xd0\x96"};
+static const char *te_emoji[]={"\xf0\x9f\x98\x80", "ok ", "\xf0\x9f\x8e\x89", "\xe2\x82\xac", " x"};
+
+/* ========================================================================= */
+// '\0' separated strings of in_piece pieces, about in_size bytes
+static char *te_text(const char **in_piece, int in_num, size_t in_size, size_t *p_len) {
+    unsigned int seed=1;
+    char *out=(char *)malloc(in_size+512);
+    size_t len=0;
+    size_t end=0;
+    const char *p=NULL;
+
+    while(len < in_size) {
+	end=len+8+td_rand(&seed) % 256;
+	while(len < end) {
+	    p=in_piece[td_rand(&seed) % in_num];
+	    memcpy(out+len, p, strlen(p));
+	    len+=strlen(p);
+	}
+	out[len++]='\0';
+    }
+    *p_len=len;
+    return(out);
+}
+/* ========================================================================= */
+// Input MB/s, in_level < 0 - u8_escape()
+static double te_run(const char *in_text, size_t in_len, char *out_buf, int in_level, int in_mode) {
+    const char *p=NULL;
+    double best=0;
+    double t=0;
+    size_t len=0;
+    int run=0;
+
+    for(run=0; run<TE_RUNS; run++) {
+	t=td_now();
+	for(p=in_text; p < in_text+in_len; p+=len+1) {
+	    len=strlen(p);
+	    if(in_level < 0) u8_escape(out_buf, V2_ESC_SIZE(len), (char *)p, 1);
+	    else             v2_esc_level(in_level, out_buf, p, len, in_mode);
+	}
+	t=td_now()-t;
+	if(!best || t < best) best=t;
+    }
+    return(in_len/1048576.0/best);
+}
+/* ========================================================================= */
+int main(int argc, char *argv[]) {
+    static const char *names[]={"ascii", "cyrillic", "emoji"};
+    static const char *levels[]={"", "scalar", "sse2", "avx2"};
+    size_t mb=(argc > 1) ? (size_t)atoi(argv[1]) : 4;
+    char ref[V2_ESC_SIZE(300)];
+    char out[V2_ESC_SIZE(300)];
+    const char *p=NULL;
+    char *text=NULL;
+    size_t len=0;
+    size_t bad=0;
+    int level=0;
+    int k=0;
+
+    printf("escape: %zu MB of strings, input MB/s\n", mb);
+    printf("  %-9s %10s", "", "u8_escape");
+    for(level=V2_SIDX_SCALAR; level<=v2_sidx_level(); level++) printf(" %7s %7s", levels[level], "quotes");
+    printf("\n");
+
+    for(k=0; k<3; k++) {
+	if(k == 0) text=te_text(te_ascii, sizeof(te_ascii)/sizeof(*te_ascii), mb << 20, &len);
+	if(k == 1) text=te_text(te_cyr, sizeof(te_cyr)/sizeof(*te_cyr), mb << 20, &len);
+	if(k == 2) text=te_text(te_emoji, sizeof(te_emoji)/sizeof(*te_emoji), mb << 20, &len);
+
+	for(p=text; p < text+len; p+=strlen(p)+1) { // The same text as u8_escape() gives
+	    u8_escape(ref, sizeof(ref), (char *)p, 1);
+	    for(level=V2_SIDX_SCALAR; level<=v2_sidx_level(); level++) {
+		v2_esc_level(level, out, p, strlen(p), V2_ESC_UTF8);
+		if(strcmp(ref, out)) bad++;
+	    }
+	}
+
+	printf("  %-9s %10.1f", names[k], te_run(text, len, out, -1, 0));
+	for(level=V2_SIDX_SCALAR; level<=v2_sidx_level(); level++) {
+	    printf(" %7.1f", te_run(text, len, out, level, V2_ESC_UTF8));
+	    printf(" %7.1f", te_run(text, len, out, level, V2_ESC_QUOTES));
+	}
+	printf("\n");
+	free(text);
+    }
+    if(bad) printf("  %zu strings differ from u8_escape()\n", bad);
+
+    return(bad ? 1 : 0);
+}
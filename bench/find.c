@@ -0,0 +1,105 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Path lookup in built tree of records (TD_RECORDS): random full ids by
+ *   - v2_json_find() - hash index
+ *   - v2_json_child() by parent and member name
+ *   - scan of chain list (json_box.chan) comparing v2_json_full_id() - what callers did before,
+ *     1000 times less lookups
+ * Every found node has to be the right one.
+ *
+ * Usage: find [MB (4)] [lookups (1000000)]
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "doc.h"
+#include "v2_jsmn.h"
+
+/* ========================================================================= */
+int main(int argc, char *argv[]) {
+    size_t mb=(argc > 1) ? (size_t)atoi(argv[1]) : 4;
+    size_t num=(argc > 2) ? (size_t)atol(argv[2]) : 1000000;
+    v2_jsmn_t jsmn;
+    json_lst_t **node=NULL;
+    json_lst_t *json=NULL;
+    char **id=NULL;
+    char *js=NULL;
+    unsigned int seed=1;
+    double t_find=0;
+    double t_child=0;
+    double t_scan=0;
+    size_t len=0;
+    size_t cnt=0;
+    size_t bad=0;
+    size_t x=0;
+    size_t i=0;
+
+    memset(&jsmn, 0, sizeof(jsmn));
+    if(!(js=td_doc(TD_RECORDS, 1, mb << 20, &len))) return(1);
+    v2_wrbuf_new(&jsmn.b);
+    v2_wrbuf_write(jsmn.b, js, 1, len);
+    free(js);
+    if(v2_jsmn_parse(&jsmn) || !jsmn.box) return(1);
+
+    for(json=jsmn.box->chan; json; json=V2_JSON_LIST(json)) cnt++; // Scalars
+    node=(json_lst_t **)malloc(cnt*sizeof(json_lst_t *));
+    id=(char **)malloc(cnt*sizeof(char *));
+    for(x=0, json=jsmn.box->chan; json; json=V2_JSON_LIST(json), x++) {
+	node[x]=json;
+	id[x]=v2_json_full_id(jsmn.box, json);
+    }
+    v2_json_find(jsmn.box, id[0]); // Index is made by the first one
+
+    t_find=td_now();
+    for(i=0; i<num; i++) {
+	x=td_rand(&seed) % cnt;
+	if(v2_json_find(jsmn.box, id[x]) != node[x]) bad++;
+    }
+    t_find=td_now()-t_find;
+
+    t_child=td_now();
+    for(i=0; i<num; i++) {
+	x=td_rand(&seed) % cnt;
+	if(v2_json_child(jsmn.box, node[x]->parent, node[x]->id) != node[x]) bad++;
+    }
+    t_child=td_now()-t_child;
+
+    t_scan=td_now();
+    for(i=0; i<num/1000+1; i++) {
+	x=td_rand(&seed) % cnt;
+	for(json=jsmn.box->chan; json && strcmp(v2_json_full_id(jsmn.box, json), id[x]); json=V2_JSON_LIST(json));
+	if(json != node[x]) bad++;
+    }
+    t_scan=td_now()-t_scan;
+
+    printf("find: %zu scalars, %zu wrong\n", cnt, bad);
+    printf("  v2_json_find()  %10.1f ns\n", t_find/num*1e9);
+    printf("  v2_json_child() %10.1f ns\n", t_child/num*1e9);
+    printf("  chain scan      %10.1f ns\n", t_scan/(num/1000+1)*1e9);
+
+    v2_json_free_box(jsmn.box);
+    free(jsmn.box);
+    v2_jsmn_init(&jsmn);
+    v2_wrbuf_free(&jsmn.b);
+    free(id);
+    free(node);
+    return(bad ? 1 : 0);
+}
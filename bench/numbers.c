@@ -0,0 +1,145 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Numbers of TD_NUMBERS document (integers, doubles, exponents): millions per second of
+ *   - v2_num_parse() right on text span
+ *   - copy to '\0' ended buffer and atof() if there is '.' else atoll() - what builder did before
+ *   - copy and strtod()
+ *   - v2_num_dtoa() and snprintf("%.17g") back to text
+ * Doubles of v2_num_parse() have to be the same as strtod() ones.
+ *
+ * Usage: numbers [MB (8)]
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "doc.h"
+#include "v2_sidx.h"
+#include "v2_num.h"
+
+#define TN_RUNS 3
+
+static volatile double tn_sink; // Results are used
+
+/* ========================================================================= */
+// Text span to buf[64] with '\0'
+static char *tn_copy(char *out_buf, const char *in_str, size_t in_len) {
+
+    if(in_len > 63) in_len=63;
+    memcpy(out_buf, in_str, in_len);
+    out_buf[in_len]='\0';
+    return(out_buf);
+}
+/* ========================================================================= */
+static void tn_print(const char *in_what, double in_t, size_t in_cnt) {
+
+    printf("  %-22s %8.1f M/s\n", in_what, in_cnt/in_t/1e6);
+}
+/* ========================================================================= */
+int main(int argc, char *argv[]) {
+    size_t mb=(argc > 1) ? (size_t)atoi(argv[1]) : 8;
+    v2_tape_t tape;
+    const char **str=NULL;
+    size_t *len=NULL;
+    double *dnum=NULL;
+    double best[5]={0};
+    double t=0;
+    double d=0;
+    long long l=0;
+    char buf[64];
+    char out[V2_NUM_DTOA_LEN];
+    char *js=NULL;
+    size_t js_len=0;
+    size_t cnt=0;
+    size_t bad=0;
+    size_t x=0;
+    int run=0;
+
+    memset(&tape, 0, sizeof(tape));
+    if(!(js=td_doc(TD_NUMBERS, 1, mb << 20, &js_len))) return(1);
+    if(v2_sidx_tape(V2_SIDX_AUTO, js, js_len, &tape)) return(1);
+
+    str=(const char **)malloc(tape.cnt*sizeof(char *));
+    len=(size_t *)malloc(tape.cnt*sizeof(size_t));
+    dnum=(double *)malloc(tape.cnt*sizeof(double));
+    for(x=0; x<tape.cnt; x++) {
+	if(V2_TAPE_TYPE(tape.w[x]) != 'p') continue;
+	str[cnt]=js+V2_TAPE_VAL(tape.w[x]);
+	len[cnt]=v2_tape_len(js, js_len, tape.w[x]);
+	dnum[cnt]=strtod(tn_copy(buf, str[cnt], len[cnt]), NULL);
+	cnt++;
+    }
+
+    for(x=0; x<cnt; x++) { // The same doubles
+	switch(v2_num_parse(str[x], len[x], &l, &d)) {
+	case V2_NUM_LONG:   if((double)l != dnum[x]) bad++; break;
+	case V2_NUM_DOUBLE: if(d != dnum[x])         bad++; break;
+	default:            bad++;
+	}
+    }
+
+    for(run=0; run<TN_RUNS; run++) {
+	t=td_now();
+	for(x=0; x<cnt; x++) {
+	    if(v2_num_parse(str[x], len[x], &l, &d) == V2_NUM_LONG) tn_sink=l;
+	    else                                                     tn_sink=d;
+	}
+	t=td_now()-t;
+	if(!best[0] || t < best[0]) best[0]=t;
+
+	t=td_now();
+	for(x=0; x<cnt; x++) {
+	    tn_copy(buf, str[x], len[x]);
+	    if(strchr(buf, '.')) tn_sink=atof(buf);
+	    else                 tn_sink=atoll(buf);
+	}
+	t=td_now()-t;
+	if(!best[1] || t < best[1]) best[1]=t;
+
+	t=td_now();
+	for(x=0; x<cnt; x++) tn_sink=strtod(tn_copy(buf, str[x], len[x]), NULL);
+	t=td_now()-t;
+	if(!best[2] || t < best[2]) best[2]=t;
+
+	t=td_now();
+	for(x=0; x<cnt; x++) tn_sink=v2_num_dtoa(dnum[x], out);
+	t=td_now()-t;
+	if(!best[3] || t < best[3]) best[3]=t;
+
+	t=td_now();
+	for(x=0; x<cnt; x++) tn_sink=snprintf(out, sizeof(out), "%.17g", dnum[x]);
+	t=td_now()-t;
+	if(!best[4] || t < best[4]) best[4]=t;
+    }
+
+    printf("numbers: %zu numbers, %zu differ from strtod()\n", cnt, bad);
+    tn_print("v2_num_parse()", best[0], cnt);
+    tn_print("copy, atof()/atoll()", best[1], cnt);
+    tn_print("copy, strtod()", best[2], cnt);
+    tn_print("v2_num_dtoa()", best[3], cnt);
+    tn_print("snprintf(\"%.17g\")", best[4], cnt);
+
+    v2_tape_free(&tape);
+    free(dnum);
+    free(len);
+    free(str);
+    free(js);
+    return(bad ? 1 : 0);
+}
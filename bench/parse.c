@@ -0,0 +1,127 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * v2_jsmn_parse() speed and memory by backend on records (TD_RECORDS) of given sizes:
+ * MB/s (best of 3), peak RSS growth by parse per input byte, tokens allocated/used.
+ * Every backend runs in own process, so peak RSS is its own.
+ * jsmn backend runs up to TP_JSMN_MB only: jsmn_parse() without JSMN_PARENT_LINKS looks for
+ * the open container back through all tokens on every close, so it is quadratic on long arrays.
+ *
+ * Usage: parse [MB ...] (1 10)
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "doc.h"
+#include "v2_jsmn.h"
+
+#define TP_JSMN_MB 4
+
+static const char *tp_back[]={"tape", "jsmn", "sidx"};
+
+/* ========================================================================= */
+static long tp_rss(void) { // Peak RSS, KB
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    return(ru.ru_maxrss);
+}
+/* ========================================================================= */
+// One backend, in child process
+static int tp_run(const char *in_js, size_t in_len, int in_back) {
+    v2_jsmn_t jsmn;
+    long rss=tp_rss();
+    double best=0;
+    double t=0;
+    int is_tape=0;
+    int tmax=0;
+    int tcnt=0;
+    int rc=0;
+    int i=0;
+
+    for(i=0; i<3 && !rc; i++) {
+	memset(&jsmn, 0, sizeof(jsmn));
+	jsmn.backend=in_back;
+	v2_wrbuf_new(&jsmn.b);
+	v2_wrbuf_write(jsmn.b, (char *)in_js, 1, in_len);
+
+	t=td_now();
+	rc=v2_jsmn_parse(&jsmn);
+	t=td_now()-t;
+	if(!best || t < best) best=t;
+
+	is_tape=(jsmn.tape.cnt > 0);
+	tmax=is_tape ? (int)jsmn.tape.max : jsmn.tmax;
+	tcnt=is_tape ? (int)jsmn.tape.cnt : jsmn.tcnt;
+
+	if(jsmn.box) {
+	    v2_json_free_box(jsmn.box);
+	    free(jsmn.box);
+	}
+	v2_jsmn_init(&jsmn);
+	v2_wrbuf_free(&jsmn.b);
+    }
+    if(rc) {
+	printf("%s: parse error %d\n", tp_back[in_back], rc);
+	return(1);
+    }
+
+    printf("  %s %8.1f MB/s %6.1f peak bytes per byte, %s %d/%d\n", tp_back[in_back], in_len/1048576.0/best,
+	   (tp_rss()-rss)*1024.0/in_len, is_tape ? "tape words" : "tokens", tmax, tcnt);
+    return(0);
+}
+/* ========================================================================= */
+int main(int argc, char *argv[]) {
+    char *js=NULL;
+    size_t len=0;
+    size_t mb=0;
+    pid_t pid=0;
+    int status=0;
+    int back=0;
+    int i=0;
+    int rc=0;
+
+    for(i=(argc > 1)?1:0; i<((argc > 1)?argc:2); i++) {
+	mb=(argc > 1) ? (size_t)atoi(argv[i]) : (i ? 10 : 1);
+	if(!(js=td_doc(TD_RECORDS, 1, mb << 20, &len))) return(1);
+
+	printf("parse: %.1f MB of records\n", len/1048576.0);
+	fflush(stdout);
+	for(back=V2_JSMN_BACK_TAPE; back<=V2_JSMN_BACK_SIDX; back++) {
+	    if(back == V2_JSMN_BACK_JSMN && mb > TP_JSMN_MB) {
+		printf("  jsmn skipped above %d MB - quadratic\n", TP_JSMN_MB);
+		fflush(stdout);
+		continue;
+	    }
+	    if((pid=fork()) == 0) {
+		rc=tp_run(js, len, back);
+		fflush(stdout);
+		_exit(rc);
+	    }
+	    if(pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) rc=1;
+	}
+	free(js);
+    }
+
+    return(rc);
+}
@@ -0,0 +1,103 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Serializer speed: v2_json_text() to memory buffer for every ident (0, 4) and no_escape (0, 1, 2)
+ * on records, mixed, numbers and strings trees - output MB/s, best of 3.
+ * Every run prints a freshly parsed tree, so no kept text of the last print is reused.
+ *
+ * Usage: print [MB (4)]
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "doc.h"
+#include "v2_jsmn.h"
+
+/* ========================================================================= */
+// Output MB/s of one print, 0 - error
+static double tp_print(const char *in_js, size_t in_len, int in_ident, int in_escape) {
+    v2_jsmn_t jsmn;
+    double t=0;
+    size_t out=0;
+
+    memset(&jsmn, 0, sizeof(jsmn));
+    v2_wrbuf_new(&jsmn.b);
+    v2_wrbuf_write(jsmn.b, (char *)in_js, 1, in_len);
+
+    if(!v2_jsmn_parse(&jsmn) && jsmn.box) {
+	jsmn.box->ident=in_ident;
+	jsmn.box->no_escape=in_escape;
+	v2_wrbuf_new(&jsmn.box->b);
+
+	t=td_now();
+	v2_json_text(jsmn.box);
+	t=td_now()-t;
+	out=jsmn.box->b->cnt;
+    }
+
+    if(jsmn.box) {
+	v2_json_free_box(jsmn.box);
+	free(jsmn.box);
+    }
+    v2_jsmn_init(&jsmn);
+    v2_wrbuf_free(&jsmn.b);
+
+    return(t > 0 ? out/1048576.0/t : 0);
+}
+/* ========================================================================= */
+int main(int argc, char *argv[]) {
+    static const int kinds[]={TD_RECORDS, TD_MIX, TD_NUMBERS, TD_STRINGS};
+    static const char *names[]={"records", "mix", "numbers", "strings"};
+    size_t mb=(argc > 1) ? (size_t)atoi(argv[1]) : 4;
+    double best=0;
+    double s=0;
+    char *js=NULL;
+    size_t len=0;
+    int ident=0;
+    int esc=0;
+    int k=0;
+    int i=0;
+
+    printf("print: %zu MB trees, output MB/s by ident/no_escape\n", mb);
+    printf("  %-8s", "");
+    for(ident=0; ident<=4; ident+=4) {
+	for(esc=0; esc<=2; esc++) printf("   %d/%d", ident, esc);
+    }
+    printf("\n");
+
+    for(k=0; k<4; k++) {
+	if(!(js=td_doc(kinds[k], 1, mb << 20, &len))) return(1);
+	printf("  %-8s", names[k]);
+	for(ident=0; ident<=4; ident+=4) {
+	    for(esc=0; esc<=2; esc++) {
+		for(best=0, i=0; i<3; i++) {
+		    if(!(s=tp_print(js, len, ident, esc))) return(1);
+		    if(s > best) best=s;
+		}
+		printf(" %5.0f", best);
+		fflush(stdout);
+	    }
+	}
+	printf("\n");
+	free(js);
+    }
+
+    return(0);
+}
@@ -0,0 +1,77 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Tape against jsmn tokens: v2_sidx_tape() and v2_sidx_parse() on every document kind,
+ * bytes of tape words and of jsmntok_t per input byte, MB/s (best of 3).
+ *
+ * Usage: tape [MB (8)]
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "doc.h"
+#include "v2_sidx.h"
+
+/* ========================================================================= */
+int main(int argc, char *argv[]) {
+    static const int kinds[]={TD_RECORDS, TD_MIX, TD_NUMBERS, TD_STRINGS};
+    static const char *names[]={"records", "mix", "numbers", "strings"};
+    size_t mb=(argc > 1) ? (size_t)atoi(argv[1]) : 8;
+    jsmntok_t *tok=NULL;
+    v2_tape_t tape;
+    double t_tape=0;
+    double t_tok=0;
+    double t=0;
+    char *js=NULL;
+    size_t len=0;
+    int tmax=0;
+    int cnt=0;
+    int k=0;
+    int i=0;
+
+    memset(&tape, 0, sizeof(tape));
+
+    printf("tape: %zu MB of every kind, level %d\n", mb, v2_sidx_level());
+    printf("  %-8s %14s %14s %10s %10s\n", "", "tape B/byte", "tokens B/byte", "tape MB/s", "tok MB/s");
+    for(k=0; k<4; k++) {
+	if(!(js=td_doc(kinds[k], 1, mb << 20, &len))) return(1);
+
+	for(t_tape=t_tok=0, i=0; i<3; i++) {
+	    tape.cnt=0;
+	    t=td_now();
+	    if(v2_sidx_tape(V2_SIDX_AUTO, js, len, &tape)) return(1);
+	    t=td_now()-t;
+	    if(!t_tape || t < t_tape) t_tape=t;
+
+	    t=td_now();
+	    if((cnt=v2_sidx_parse(V2_SIDX_AUTO, js, len, &tok, &tmax)) < 0) return(1);
+	    t=td_now()-t;
+	    if(!t_tok || t < t_tok) t_tok=t;
+	}
+
+	printf("  %-8s %14.2f %14.2f %10.1f %10.1f\n", names[k], (double)tape.cnt*sizeof(uint64_t)/len, (double)cnt*sizeof(jsmntok_t)/len,
+	       len/1048576.0/t_tape, len/1048576.0/t_tok);
+	free(js);
+    }
+
+    v2_tape_free(&tape);
+    free(tok);
+    return(0);
+}
@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Tree build scaling by v2_jsmn_t.threads: root array of records (TD_RECORDS) is parsed
+ * with 1, 2, 4 ... N builder threads, best of 3 runs each.
+ *
+ * Usage: threads [MB (32)] [max threads (online CPUs)]
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "doc.h"
+#include "v2_jsmn.h"
+
+/* ========================================================================= */
+// Seconds of one v2_jsmn_parse() (tape and tree), -1 - error
+static double tb_parse(const char *in_js, size_t in_len, int in_threads) {
+    v2_jsmn_t jsmn;
+    double t=0;
+    int rc=0;
+
+    memset(&jsmn, 0, sizeof(jsmn));
+    jsmn.threads=in_threads;
+    v2_wrbuf_new(&jsmn.b);
+    v2_wrbuf_write(jsmn.b, (char *)in_js, 1, in_len);
+
+    t=td_now();
+    rc=v2_jsmn_parse(&jsmn);
+    t=td_now()-t;
+
+    if(jsmn.box) {
+	v2_json_free_box(jsmn.box);
+	free(jsmn.box);
+    }
+    v2_jsmn_init(&jsmn);
+    v2_wrbuf_free(&jsmn.b);
+
+    return(rc ? -1 : t);
+}
+/* ========================================================================= */
+int main(int argc, char *argv[]) {
+    size_t mb=(argc > 1) ? (size_t)atoi(argv[1]) : 32;
+    int max=(argc > 2) ? atoi(argv[2]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    double one=0;
+    double best=0;
+    double t=0;
+    char *js=NULL;
+    size_t len=0;
+    int n=0;
+    int i=0;
+
+    if(max < 1) max=1;
+    if(max > V2_JSMN_THREADS_MAX) max=V2_JSMN_THREADS_MAX;
+    if(!(js=td_doc(TD_RECORDS, 1, mb << 20, &len))) return(1);
+
+    printf("threads: %.1f MB of records, 1..%d threads\n", len/1048576.0, max);
+    for(n=1; ; n*=2) { // Powers of 2 and max
+	if(n > max) n=max;
+	for(best=0, i=0; i<3; i++) {
+	    if((t=tb_parse(js, len, n)) < 0) {
+		printf("parse error\n");
+		return(1);
+	    }
+	    if(!best || t < best) best=t;
+	}
+	if(n == 1) one=best;
+	printf("%3d %8.1f MB/s %6.2fx\n", n, len/1048576.0/best, one/best);
+	if(n == max) break;
+    }
+
+    free(js);
+    return(0);
+}
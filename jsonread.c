@@ -49,14 +49,37 @@ int jr2_fm_locale(char *in_str) {
     return(0);
 }*/
 /* ======================================================== */
+// --lines: print every record as one line
+int jr_line(v2_jsmn_t *in_jsmn, void *in_data) {
+
+    if(!in_jsmn->box) {
+	printf("[]\n");
+	return(0);
+    }
+
+    in_jsmn->box->ident=0;
+    in_jsmn->box->no_escape=0; // Escaped - new lines in strings do not break records
+
+    v2_json_locale(in_jsmn->box, getenv("LC_ALL"), 1); // DeLocalize it
+
+    return(v2_json_text(in_jsmn->box));
+}
+/* ======================================================== */
 int main(int argc, char *argv[], char *argp[]) {
     //json_lst_t *jsn=NULL;
     char *in_file=NULL;
+    int is_lines=0;
     int rc=0;
 
+    if(argc > 1 && !strcmp(argv[1], "--lines")) { // JSON Lines - one json per line
+	is_lines=1;
+	argc--;
+	argv++;
+    }
+
     if(argc == 1) {
 	if(isatty(fileno(stdin))) {
-	    fprintf(stderr, "Usage:\n\t%s file.json|-\n", argv[0]);
+	    fprintf(stderr, "Usage:\n\t%s [--lines] file.json|-\n", argv[0]);
 	    return(0);
 	} else if(errno != ENOTTY) {
 	    fprintf(stderr, "Error: %d %s\n", errno, strerror(errno));
@@ -73,6 +96,15 @@ int main(int argc, char *argv[], char *argp[]) {
     //    if(strncmp(locale, "ru", 2)) locale=NULL;
     //}
 
+    if(getenv("JSONREAD_THREADS")) jr_jsmn.threads=atoi(getenv("JSONREAD_THREADS")); // Builder threads for big arrays
+
+    if(is_lines) {
+	if((rc=v2_jsmn_lines(&jr_jsmn, in_file, jr_line, NULL))) {
+	    fprintf(stderr, "ERROR Returned code = %d, line %zu\n", rc, jr_jsmn.lnum);
+	}
+	return(0);
+    }
+
     if((rc=v2_jsmn_parse_file(&jr_jsmn, in_file))) {
 	fprintf(stderr, "ERROR Returned code = %d\n", rc);
         return(0);
@@ -0,0 +1,206 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "doc.h"
+#include "v2_wrbuf.h"
+
+// String pieces: plain, escaped, raw UTF-8 (2, 3 and 4 bytes)
+static const char *td_piece[] = {
+    "a", "Z", "k", " ", "0", "user", "-", "~", "/",
+    "\\\"", "\\\\", "\\/", "\\n", "\\t", "\\r", "\\b", "\\f", "\\u00e9", "\\u0416", "\\u20AC", "\\u0001",
+    "\xd0\x96", "\xe2\x82\xac", "\xf0\x9f\x98\x80"
+};
+#define TD_PIECES (sizeof(td_piece)/sizeof(*td_piece))
+
+static const char *td_space[] = { "", "", "", " ", "\n", "\t", "  \r\n" };
+#define TD_SPACES (sizeof(td_space)/sizeof(*td_space))
+
+/* ========================================================================= */
+unsigned int td_rand(unsigned int *p_seed) {
+    unsigned int x=*p_seed;
+
+    x^=x << 13;
+    x^=x >> 17;
+    x^=x << 5;
+    return(*p_seed=x);
+}
+/* ========================================================================= */
+static void td_str(wrbuf_t *b, unsigned int *p_seed, size_t in_max) {
+    size_t n=td_rand(p_seed)%(in_max+1);
+
+    v2_wrbuf_putc(b, '"');
+    while(n--) v2_wrbuf_puts(b, td_piece[td_rand(p_seed)%TD_PIECES]);
+    v2_wrbuf_putc(b, '"');
+}
+/* ========================================================================= */
+static void td_num(wrbuf_t *b, unsigned int *p_seed) {
+    unsigned int r=td_rand(p_seed);
+
+    switch(r%4) {
+    case 0: v2_wrbuf_put_i64(b, (long long)(td_rand(p_seed)%2000)-1000); break;
+    case 1: v2_wrbuf_put_i64(b, ((long long)td_rand(p_seed) << 20)*((r & 16)?-1:1)); break;
+    case 2: v2_wrbuf_printf(b, "%.*g", 1+td_rand(p_seed)%17, (double)td_rand(p_seed)/(1+td_rand(p_seed)%100000)); break;
+    case 3: v2_wrbuf_printf(b, "%d.%de%c%d", (int)(td_rand(p_seed)%100)-50, td_rand(p_seed)%1000, (r & 16)?'-':'+', td_rand(p_seed)%300); break;
+    }
+}
+/* ========================================================================= */
+static void td_sp(wrbuf_t *b, unsigned int *p_seed) {
+
+    v2_wrbuf_puts(b, td_space[td_rand(p_seed)%TD_SPACES]);
+}
+/* ========================================================================= */
+// Value of TD_MIX, containers go deeper till in_dep
+static void td_mix(wrbuf_t *b, unsigned int *p_seed, int in_dep) {
+    unsigned int r=td_rand(p_seed)%10;
+    unsigned int n=0;
+    unsigned int x=0;
+
+    if(in_dep > 0 && r < 2) {
+	n=td_rand(p_seed)%6;
+	v2_wrbuf_putc(b, '{');
+	for(x=0; x<n; x++) {
+	    if(x) v2_wrbuf_putc(b, ',');
+	    td_sp(b, p_seed);
+	    if(td_rand(p_seed)%16) td_str(b, p_seed, 4);
+	    else                   v2_wrbuf_puts(b, "\"\""); // Empty name - "_array_NNNN" one
+	    td_sp(b, p_seed);
+	    v2_wrbuf_putc(b, ':');
+	    td_sp(b, p_seed);
+	    td_mix(b, p_seed, in_dep-1);
+	}
+	td_sp(b, p_seed);
+	v2_wrbuf_putc(b, '}');
+	return;
+    }
+    if(in_dep > 0 && r < 4) {
+	n=td_rand(p_seed)%7;
+	v2_wrbuf_putc(b, '[');
+	for(x=0; x<n; x++) {
+	    if(x) v2_wrbuf_putc(b, ',');
+	    td_sp(b, p_seed);
+	    td_mix(b, p_seed, in_dep-1);
+	}
+	td_sp(b, p_seed);
+	v2_wrbuf_putc(b, ']');
+	return;
+    }
+
+    switch(r) {
+    case 4:
+    case 5: td_str(b, p_seed, 12); break;
+    case 6:
+    case 7: td_num(b, p_seed); break;
+    case 8: v2_wrbuf_puts(b, (td_rand(p_seed) & 1)?"true":"false"); break;
+    default: v2_wrbuf_puts(b, "null"); break;
+    }
+}
+/* ========================================================================= */
+char *td_doc(int in_kind, unsigned int in_seed, size_t in_size, size_t *p_len) {
+    wrbuf_t *b=NULL;
+    char *doc=NULL;
+    unsigned int seed=in_seed?in_seed:1;
+    int is_obj=seed & 1;
+    size_t x=0;
+
+    if(v2_wrbuf_new(&b)) return(NULL);
+
+    switch(in_kind) {
+    case TD_RECORDS:
+	v2_wrbuf_putc(b, '[');
+	for(x=0; !x || b->cnt < in_size; x++) {
+	    if(x) v2_wrbuf_puts(b, ", ");
+	    v2_wrbuf_printf(b, "{\"id\": %zu, \"name\": \"user%zu\", \"score\": %.17g, \"tags\": [\"a\", \"b\\\"q\", \"c\"], "
+			    "\"ok\": %s, \"n\": null, \"sector1\": \"v\", \"sector2\": \"w\"}",
+			    x, x, (double)td_rand(&seed)/4294967296.0*100, (td_rand(&seed) & 1)?"true":"false");
+	}
+	v2_wrbuf_putc(b, ']');
+	break;
+    case TD_NUMBERS:
+	v2_wrbuf_putc(b, '[');
+	for(x=0; !x || b->cnt < in_size; x++) {
+	    if(x) v2_wrbuf_puts(b, ", ");
+	    td_num(b, &seed);
+	}
+	v2_wrbuf_putc(b, ']');
+	break;
+    case TD_STRINGS:
+	v2_wrbuf_putc(b, '{');
+	for(x=0; !x || b->cnt < in_size; x++) {
+	    if(x) v2_wrbuf_puts(b, ", ");
+	    v2_wrbuf_printf(b, "\"s%zu\": ", x);
+	    td_str(b, &seed, (x % 50)?60:3000);
+	}
+	v2_wrbuf_putc(b, '}');
+	break;
+    case TD_DEEP:
+	for(x=0; x<in_size; x++) v2_wrbuf_puts(b, (x & 1)?"{\"a\": ":"[1, ");
+	v2_wrbuf_puts(b, "\"end\"");
+	for(x=in_size; x>0; x--) v2_wrbuf_putc(b, ((x-1) & 1)?'}':']');
+	break;
+    default: // TD_MIX: root is object or array, it has to be the first byte
+	v2_wrbuf_putc(b, is_obj?'{':'[');
+	for(x=0; !x || b->cnt < in_size; x++) {
+	    if(x) v2_wrbuf_putc(b, ',');
+	    td_sp(b, &seed);
+	    if(is_obj) {
+		td_str(b, &seed, 4);
+		v2_wrbuf_putc(b, ':');
+		td_sp(b, &seed);
+	    }
+	    td_mix(b, &seed, 5);
+	}
+	v2_wrbuf_putc(b, is_obj?'}':']');
+	break;
+    }
+
+    if(b->buf && b->cnt) { // Take text from buffer
+	doc=b->buf;
+	if(p_len) *p_len=b->cnt;
+	b->buf=NULL;
+    }
+    v2_wrbuf_free(&b);
+
+    return(doc);
+}
+/* ========================================================================= */
+char *td_file(const char *in_file, size_t *p_len) {
+    wrbuf_t *b=NULL;
+    char *doc=NULL;
+
+    if(v2_wrbuf_new(&b)) return(NULL);
+
+    if(!v2_wrbuf_file_read(b, (char *)"%s", in_file) && b->buf) {
+	doc=b->buf;
+	if(p_len) *p_len=b->cnt;
+	b->buf=NULL;
+    }
+    v2_wrbuf_free(&b);
+
+    return(doc);
+}
+/* ========================================================================= */
+double td_now(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return(t.tv_sec+t.tv_nsec/1e9);
+}
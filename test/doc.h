@@ -0,0 +1,47 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_DOC_H
+#define _TD_DOC_H 1
+
+/*
+ * Json documents for checks (test/) and benchmarks (bench/).
+ * The same kind, seed and size always give the same text.
+ */
+
+#include <stdlib.h>
+
+// Document kinds
+#define TD_MIX     0 // Random nesting of objects and arrays with every value type, random spaces
+#define TD_RECORDS 1 // Root array of flat records: ids, names, doubles, short arrays, literals
+#define TD_NUMBERS 2 // Root array of integers and doubles with exponents
+#define TD_STRINGS 3 // Root object of strings with escapes, controls, UTF-8 and emoji, some long
+#define TD_DEEP    4 // in_size levels of nested arrays and objects
+
+unsigned int td_rand(unsigned int *p_seed); // xorshift32, *p_seed != 0
+
+// Valid json of in_kind about in_size bytes (levels for TD_DEEP), malloc()-ed and '\0' ended, NULL - no memory
+char *td_doc(int in_kind, unsigned int in_seed, size_t in_size, size_t *p_len);
+
+// Whole file, malloc()-ed and '\0' ended, NULL - can not read
+char *td_file(const char *in_file, size_t *p_len);
+
+// Seconds by monotonic clock
+double td_now(void);
+
+#endif // _TD_DOC_H
@@ -0,0 +1,136 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * v2_num_dtoa() text is the shortest one what reads back the same:
+ *   - known values print as expected - 1e23, powers of 2, subnormals, limits
+ *   - random bit patterns read back bit-exact by strtod() and have no more digits
+ *     than the first of printf("%.1e") .. ("%.16e") what reads back
+ *
+ * Usage: dtoa [random doubles (200000)]
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <float.h>
+
+#include "doc.h"
+#include "v2_num.h"
+
+static int dt_bad=0;
+
+static const struct {
+    double d;
+    const char *txt;
+} dt_known[]={
+    { 1e23,                    "1e+23" },
+    { 5e-324,                  "5e-324" },
+    { DBL_MAX,                 "1.7976931348623157e+308" },
+    { DBL_MIN,                 "2.2250738585072014e-308" },
+    { 0.1,                     "0.1" },
+    { 0.3,                     "0.3" },
+    { 0.1+0.2,                 "0.30000000000000004" },
+    { 1.0/3,                   "0.3333333333333333" },
+    { 13.436424411240122,      "13.436424411240122" },
+    { 9007199254740993.0,      "9007199254740992" },
+    { 1e16,                    "10000000000000000" },
+    { 1e17,                    "1e+17" },
+    { 1e-5,                    "1e-05" },
+    { 123456.0,                "123456" },
+    { -2.5,                    "-2.5" },
+    { -0.0,                    "-0" },
+    { 2251799813685248.0,      "2251799813685248" }, // 2^51
+    { 8.41e21,                 "8.41e+21" },
+    { 5.0e-310,                "5e-310" }
+};
+
+/* ========================================================================= */
+static void dt_fail(const char *in_what, double in_d, const char *in_txt) {
+
+    if(dt_bad++ < 10) printf("FAIL %s: %.17g printed as %s\n", in_what, in_d, in_txt);
+}
+/* ========================================================================= */
+// Significant digits of d.ddde+XX or plain text
+static int dt_digits(const char *in_txt) {
+    int cnt=0;  // Digits from first non zero one
+    int last=1; // cnt at last non zero one
+    int i=0;
+
+    for(i=0; in_txt[i] && in_txt[i] != 'e'; i++) {
+	if(in_txt[i] < '0' || in_txt[i] > '9') continue;
+	if(in_txt[i] == '0' && !cnt) continue;
+	cnt++;
+	if(in_txt[i] != '0') last=cnt;
+    }
+    return(last);
+}
+/* ========================================================================= */
+static void dt_check(double in_d) {
+    char txt[V2_NUM_DTOA_LEN];
+    char ref[40];
+    int prec=1;
+
+    v2_num_dtoa(in_d, txt);
+    if(memcmp(&in_d, &(double){strtod(txt, NULL)}, sizeof(double))) {
+	dt_fail("does not read back", in_d, txt);
+	return;
+    }
+
+    for(prec=1; prec < 17; prec++) {
+	snprintf(ref, sizeof(ref), "%.*e", prec-1, in_d);
+	if(strtod(ref, NULL) == in_d) break;
+    }
+    if(dt_digits(txt) > prec) dt_fail("is not the shortest", in_d, txt);
+}
+/* ========================================================================= */
+int main(int argc, char *argv[]) {
+    char txt[V2_NUM_DTOA_LEN];
+    char ref[40];
+    unsigned int seed=22;
+    uint64_t bits=0;
+    double d=0;
+    long cnt=200000;
+    long i=0;
+    size_t k=0;
+
+    if(argc > 1) cnt=atol(argv[1]);
+
+    for(k=0; k<sizeof(dt_known)/sizeof(dt_known[0]); k++) {
+	v2_num_dtoa(dt_known[k].d, txt);
+	if(strcmp(txt, dt_known[k].txt)) dt_fail(dt_known[k].txt, dt_known[k].d, txt);
+	dt_check(dt_known[k].d);
+    }
+
+    for(i=0; i<cnt; i++) {
+	bits=((uint64_t)td_rand(&seed) << 32) | td_rand(&seed);
+	memcpy(&d, &bits, sizeof(d));
+	if(d != d || d-d != 0) continue; // NaN, Inf
+	dt_check(d);
+    }
+
+    for(i=1; i<1000; i++) { // Short decimals - %g ones did not change
+	d=(double)i/1000;
+	v2_num_dtoa(d, txt);
+	snprintf(ref, sizeof(ref), "%g", d);
+	if(strcmp(txt, ref)) dt_fail("differs from %g", d, txt);
+    }
+
+    printf("dtoa: %zu known, %ld random doubles: %s\n", k, cnt, dt_bad ? "FAILED" : "ok");
+    return(dt_bad ? 1 : 0);
+}
@@ -0,0 +1,233 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Re-print with keep_text gives the same text as a fresh print:
+ *   - two boxes are parsed from the same document, one prints with keep_text, other one with keep_text 0
+ *   - both get the same changes step by step: v2_json_set_*() of random values, v2_json_str() appended
+ *     to random containers, one shared subtree put twice by v2_json_jref() at different depths,
+ *     ident and no_escape changed
+ *   - every text of the keep_text box is byte-identical to the other one
+ * Shared values are read only - v2_json_set_*() returns 17365 for them.
+ *
+ * Usage: keep [steps (300)]
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "doc.h"
+#include "v2_jsmn.h"
+
+#define KP_BOXES 2 // 0 - keep_text, 1 - fresh print
+
+typedef struct {
+    v2_jsmn_t jsmn;
+    json_lst_t **val; // Scalars in walk order
+    json_lst_t **con; // Not empty containers in walk order
+    size_t vcnt;
+    size_t ccnt;
+} kp_box_t;
+
+static kp_box_t kp_box[KP_BOXES];
+static int kp_bad=0;
+static int kp_texts=0;
+
+/* ========================================================================= */
+static void kp_fail(const char *in_what, int in_step) {
+
+    if(kp_bad++ < 10) printf("FAIL %s, step %d\n", in_what, in_step);
+}
+/* ========================================================================= */
+// Parse in_js to in_kb, nodes to its val and con lists
+static int kp_parse(kp_box_t *in_kb, const char *in_js, size_t in_len) {
+    json_lst_t *node=NULL;
+    int rc=0;
+
+    memset(in_kb, 0, sizeof(kp_box_t));
+    v2_wrbuf_new(&in_kb->jsmn.b);
+    v2_wrbuf_write(in_kb->jsmn.b, (char *)in_js, 1, in_len);
+    if((rc=v2_jsmn_parse(&in_kb->jsmn))) return(rc);
+
+    in_kb->val=(json_lst_t **)malloc(in_len*sizeof(json_lst_t *)); // Not more nodes than bytes
+    in_kb->con=(json_lst_t **)malloc(in_len*sizeof(json_lst_t *));
+
+    for(node=in_kb->jsmn.box->lst; node; ) {
+	if(node->child) {
+	    in_kb->con[in_kb->ccnt++]=node;
+	    node=node->child;
+	    continue;
+	}
+	if(node->js_type != JS_OBJECT && node->js_type != JS_ARRAY) in_kb->val[in_kb->vcnt++]=node;
+
+	while(node && !node->next) node=node->parent;
+	if(node) node=node->next;
+    }
+    return(0);
+}
+/* ========================================================================= */
+static void kp_free(kp_box_t *in_kb) {
+
+    v2_json_free_box(in_kb->jsmn.box);
+    free(in_kb->jsmn.box);
+    v2_jsmn_init(&in_kb->jsmn);
+    v2_wrbuf_free(&in_kb->jsmn.b);
+    free(in_kb->val);
+    free(in_kb->con);
+}
+/* ========================================================================= */
+// Last one of in_node and its next ones - next value goes after it
+static void kp_tek(json_box_t *in_jbox, json_lst_t *in_node) {
+    json_lst_t *node=in_node;
+
+    while(node->next) node=node->next;
+    in_jbox->tek=node;
+}
+/* ========================================================================= */
+// The same change of both boxes by in_r
+static int kp_change(unsigned int in_r, int in_step, json_ref_t *in_ref) {
+    json_box_t *box=NULL;
+    json_lst_t *node=NULL;
+    char str[64];
+    int rc=0;
+    int b=0;
+
+    snprintf(str, sizeof(str), "step %d \"%u\"\n", in_step, in_r);
+
+    for(b=0; b<KP_BOXES && !rc; b++) {
+	box=kp_box[b].jsmn.box;
+
+	if(in_r % 16 == 0 && kp_box[b].ccnt) { // Append to container
+	    kp_tek(box, kp_box[b].con[(in_r >> 4) % kp_box[b].ccnt]->child);
+	    rc=v2_json_str(box, str+5, str);
+	    continue;
+	}
+
+	if(!kp_box[b].vcnt) continue;
+	node=kp_box[b].val[(in_r >> 4) % kp_box[b].vcnt];
+
+	switch(in_r % 8) {
+	case 0:
+	case 1: rc=v2_json_set_str(box, node, str);                            break;
+	case 2: rc=v2_json_set_int(box, node, (int)in_r);                      break;
+	case 3: rc=v2_json_set_lint(box, node, (long long)in_r << 20);         break;
+	case 4: rc=v2_json_set_double(box, node, (double)in_r / 7);            break;
+	case 5: rc=v2_json_set_bool(box, node, in_r & 32);                     break;
+	case 6: rc=v2_json_set_null(box, node);                                break;
+	case 7: rc=v2_json_set_double(box, node, (double)(in_r % 1000) / 100); break;
+	}
+    }
+
+    if(!rc && in_ref && kp_box[0].ccnt) { // Shared one - at root and deep, twice in each box
+	for(b=0; b<KP_BOXES && !rc; b++) {
+	    box=kp_box[b].jsmn.box;
+	    kp_tek(box, (box->lst->child && !strcmp(box->lst->id, "_")) ? box->lst->child : box->lst); // Root array "_" or members
+	    if(!(rc=v2_json_jref(box, "shared", in_ref))) {
+		kp_tek(box, kp_box[b].con[kp_box[b].ccnt-1]->child);
+		rc=v2_json_jref(box, "shared_deep", in_ref);
+	    }
+	}
+    }
+
+    return(rc);
+}
+/* ========================================================================= */
+// Print both, keep_text one has to be the same
+static void kp_print(int in_step, int in_ident, int in_no_escape) {
+    json_box_t *box=NULL;
+    int b=0;
+
+    for(b=0; b<KP_BOXES; b++) {
+	box=kp_box[b].jsmn.box;
+	box->keep_text=(b == 0);
+	box->ident=in_ident;
+	box->no_escape=in_no_escape;
+	if(!box->b) v2_wrbuf_new(&box->b);
+	if(v2_json_text(box)) kp_fail("v2_json_text() failed", in_step);
+    }
+
+    if(kp_box[0].jsmn.box->b->cnt != kp_box[1].jsmn.box->b->cnt
+       || memcmp(kp_box[0].jsmn.box->b->buf, kp_box[1].jsmn.box->b->buf, kp_box[1].jsmn.box->b->cnt)) kp_fail("text differs", in_step);
+    kp_texts++;
+}
+/* ========================================================================= */
+// Shared subtree of a few values
+static json_ref_t *kp_ref(void) {
+    json_box_t *box=NULL;
+    json_ref_t *ref=NULL;
+
+    v2_json_new(&box);
+    v2_json_str(box, "name", "shared \"one\"");
+    v2_json_arr(box, "list");
+    v2_json_int(box, NULL, 1);
+    v2_json_double(box, NULL, 2.5);
+    v2_json_obj(box, NULL);
+    v2_json_bool(box, "deep", 1);
+    v2_json_end(box);
+    v2_json_end(box);
+    v2_json_null(box, "none");
+
+    if(v2_json_ref(box, &ref)) ref=NULL;
+    v2_json_free_box(box);
+    free(box);
+    return(ref);
+}
+/* ========================================================================= */
+static void kp_doc(int in_kind, unsigned int in_seed, size_t in_size, int in_steps) {
+    json_ref_t *ref=kp_ref();
+    unsigned int seed=in_seed;
+    size_t len=0;
+    char *js=td_doc(in_kind, in_seed, in_size, &len);
+    int step=0;
+    int b=0;
+
+    for(b=0; b<KP_BOXES; b++) {
+	if(kp_parse(&kp_box[b], js, len)) kp_fail("parse failed", -1);
+    }
+
+    if(kp_box[0].jsmn.box && kp_box[1].jsmn.box) {
+	kp_print(0, 4, 1);
+	kp_print(0, 4, 1); // Nothing changed - all is copied
+
+	for(step=1; step<=in_steps; step++) {
+	    if(kp_change(td_rand(&seed), step, (step == in_steps/2) ? ref : NULL)) kp_fail("change failed", step);
+	    if(step % 3) continue; // Some changes at once
+	    kp_print(step, (step % 60 == 0) ? 0 : 4, (step % 90 == 0) ? 0 : 1);
+	}
+
+	if(v2_json_set_int(kp_box[0].jsmn.box, ref->json->child, 1) != 17365) kp_fail("shared value changed", step);
+    }
+
+    for(b=0; b<KP_BOXES; b++) kp_free(&kp_box[b]);
+    v2_json_unref(&ref);
+    free(js);
+}
+/* ========================================================================= */
+int main(int argc, char *argv[]) {
+    int steps=300;
+
+    if(argc > 1) steps=atoi(argv[1]);
+
+    kp_doc(TD_MIX,     20, 40000, steps);
+    kp_doc(TD_RECORDS, 21, 40000, steps);
+    kp_doc(TD_STRINGS, 22, 20000, steps);
+    kp_doc(TD_MIX,     23, 2000,  steps);
+
+    printf("keep: %d texts: %s\n", kp_texts, kp_bad ? "FAILED" : "ok");
+    return(kp_bad ? 1 : 0);
+}
@@ -0,0 +1,237 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Shared subtrees live while they have owners:
+ *   - one json_ref_t is put to several boxes, to other shared subtree and to a sub box joined
+ *     by v2_json_add_box(), every owner is counted once
+ *   - owners are dropped in every order (v2_json_unref() of makers, v2_json_free_box(),
+ *     v2_json_free_sub()) - boxes left print the same text, the last owner frees it
+ *   - threads put one shared subtree to their own boxes, print and free them at once
+ * Memory is checked by sanitizers: make asan, make stress
+ *
+ * Usage: refs [thread rounds (200)]
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "v2_json.h"
+
+#define RF_DROPS   4 // Maker of A, maker of B, box X, box Y - in every order
+#define RF_THREADS 4
+
+#define RF_A "{\"name\": \"shared \\\"A\\\"\",\"list\": [1,2.5,{\"deep\": true}],\"none\": null}"
+#define RF_B "{\"title\": \"B\",\"a\": " RF_A "}"
+
+static const char *rf_text[2]={ // X, Y - ident 0
+    "{\"x\": 1,\"a\": " RF_A ",\"arr\": [\"s\",{\"sub_a\": " RF_A "}]}\n",
+    "{\"b\": " RF_B ",\"obj\": {\"y\": 2,\"a\": " RF_A "},\"a2\": " RF_A "}\n"
+};
+
+static int rf_bad=0;
+static int rf_orders=0;
+static int rf_rounds=200;
+static json_ref_t *rf_shared=NULL; // For threads
+
+/* ========================================================================= */
+static void rf_fail(const char *in_what, int in_order, int in_step) {
+
+    if(__sync_fetch_and_add(&rf_bad, 1) < 10) printf("FAIL %s, order %d, step %d\n", in_what, in_order, in_step);
+}
+/* ========================================================================= */
+// Shared subtree A
+static json_ref_t *rf_make_a(void) {
+    json_box_t *box=NULL;
+    json_ref_t *ref=NULL;
+
+    v2_json_new(&box);
+    v2_json_str(box, "name", "shared \"A\"");
+    v2_json_arr(box, "list");
+    v2_json_int(box, NULL, 1);
+    v2_json_double(box, NULL, 2.5);
+    v2_json_obj(box, NULL);
+    v2_json_bool(box, "deep", 1);
+    v2_json_end(box);
+    v2_json_end(box);
+    v2_json_null(box, "none");
+
+    if(v2_json_ref(box, &ref)) ref=NULL;
+    v2_json_free_box(box);
+    free(box);
+    return(ref);
+}
+/* ========================================================================= */
+// Shared subtree B with A in it - B owns A
+static json_ref_t *rf_make_b(json_ref_t *in_a) {
+    json_box_t *box=NULL;
+    json_ref_t *ref=NULL;
+
+    v2_json_new(&box);
+    v2_json_str(box, "title", "B");
+    v2_json_jref(box, "a", in_a);
+
+    if(v2_json_ref(box, &ref)) ref=NULL;
+    v2_json_free_box(box);
+    free(box);
+    return(ref);
+}
+/* ========================================================================= */
+// Box text has to be in_text
+static void rf_check(json_box_t *in_jbox, const char *in_text, int in_order, int in_step) {
+
+    in_jbox->ident=0;
+    v2_wrbuf_new(&in_jbox->b);
+    if(v2_json_text(in_jbox) || !in_jbox->b->buf || strcmp(in_jbox->b->buf, in_text)) rf_fail("text differs", in_order, in_step);
+}
+/* ========================================================================= */
+// Owners of A and B are dropped in order in_order (permutation number), sub box is joined to X if is_join
+static void rf_order(int in_order, int is_join) {
+    json_box_t *box[2]={NULL, NULL}; // X, Y
+    json_box_t sub;
+    json_ref_t *a=rf_make_a();
+    json_ref_t *b=a ? rf_make_b(a) : NULL;
+    json_ref_t *ra=a; // Makers' pointers are NULL-ed by v2_json_unref()
+    json_ref_t *rb=b;
+    int order[RF_DROPS];
+    int left[RF_DROPS]={1, 1, 1, 1};
+    int cnt_a=0, cnt_b=0;
+    int n=in_order;
+    int i=0, k=0, t=0;
+
+    if(!a || !b) {
+	rf_fail("v2_json_ref() failed", in_order, -1);
+	return;
+    }
+
+    // X: a, sub box with a in array
+    v2_json_new(&box[0]);
+    v2_json_int(box[0], "x", 1);
+    v2_json_jref(box[0], "a", a);
+    v2_json_arr(box[0], "arr");
+    v2_json_str(box[0], NULL, "s");
+    if(v2_json_sub(box[0], &sub)) rf_fail("v2_json_sub() failed", in_order, -1);
+    v2_json_obj(&sub, NULL);
+    v2_json_jref(&sub, "sub_a", a);
+    v2_json_end(&sub);
+
+    // Y: b, a twice at other depths
+    v2_json_new(&box[1]);
+    v2_json_jref(box[1], "b", b);
+    v2_json_obj(box[1], "obj");
+    v2_json_int(box[1], "y", 2);
+    v2_json_jref(box[1], "a", a);
+    v2_json_end(box[1]);
+    v2_json_jref(box[1], "a2", a);
+
+    if(a->cnt != 6 || b->cnt != 2) rf_fail("owners are not counted", in_order, -1); // A: maker, B, X, sub, Y twice
+
+    if(is_join) {
+	if(v2_json_add_box(box[0], &sub)) rf_fail("v2_json_add_box() failed", in_order, -1);
+	if(a->cnt != 6 || sub.rcnt) rf_fail("sub box owner is not moved", in_order, -1);
+    } else {
+	v2_json_free_sub(&sub); // Dropped - not joined
+	if(a->cnt != 5) rf_fail("sub box owner is not dropped", in_order, -1);
+    }
+    v2_json_end(box[0]);
+
+    // Permutation by its number
+    for(i=0; i<RF_DROPS; i++) order[i]=i;
+    for(i=RF_DROPS-1; i>0; i--) {
+	k=n % (i+1);
+	n/=i+1;
+	t=order[i];
+	order[i]=order[k];
+	order[k]=t;
+    }
+
+    for(i=0; i<RF_DROPS; i++) {
+	if(left[2]) rf_check(box[0], is_join ? rf_text[0] : "{\"x\": 1,\"a\": " RF_A ",\"arr\": [\"s\"]}\n", in_order, i);
+	if(left[3]) rf_check(box[1], rf_text[1], in_order, i);
+
+	// Owners left: B lives while its maker or Y has it
+	cnt_b=left[1] + left[3];
+	cnt_a=left[0] + (cnt_b > 0) + left[2]*(is_join ? 2 : 1) + left[3]*2;
+	if(ra->cnt != cnt_a) rf_fail("owners of A are wrong", in_order, i);
+	if(cnt_b && rb->cnt != cnt_b) rf_fail("owners of B are wrong", in_order, i);
+
+	switch(order[i]) {
+	case 0: v2_json_unref(&a); break;
+	case 1: v2_json_unref(&b); break;
+	case 2:
+	case 3:
+	    v2_json_free_box(box[order[i]-2]);
+	    free(box[order[i]-2]);
+	    break;
+	}
+	left[order[i]]=0;
+    }
+
+    if(a || b) rf_fail("v2_json_unref() did not clean pointer", in_order, -1);
+    rf_orders++;
+}
+/* ========================================================================= */
+static void *rf_run(void *in_arg) {
+    long id=(long)in_arg;
+    json_box_t *box=NULL;
+    int i=0;
+
+    for(i=0; i<rf_rounds; i++) {
+	v2_json_new(&box);
+	v2_json_int(box, "id", (int)id);
+	v2_json_jref(box, "a", rf_shared);
+	v2_json_end(box);
+
+	box->ident=0;
+	v2_wrbuf_new(&box->b);
+	if(v2_json_text(box) || !box->b->buf || !strstr(box->b->buf, RF_A)) rf_fail("thread text differs", (int)id, i);
+
+	v2_json_free_box(box);
+    }
+    free(box);
+    return(NULL);
+}
+/* ========================================================================= */
+int main(int argc, char *argv[]) {
+    pthread_t thr[RF_THREADS];
+    json_box_t *keep=NULL;
+    json_ref_t *maker=NULL;
+    int i=0;
+
+    if(argc > 1) rf_rounds=atoi(argv[1]);
+
+    for(i=0; i<24; i++) { // All RF_DROPS! orders, sub box joined or dropped
+	rf_order(i, 1);
+	rf_order(i, 0);
+    }
+
+    // Threads own one shared subtree at once, its maker drops it while they run, box keep frees it
+    maker=rf_shared=rf_make_a();
+    v2_json_new(&keep);
+    v2_json_jref(keep, "a", rf_shared);
+    for(i=0; i<RF_THREADS; i++) pthread_create(&thr[i], NULL, rf_run, (void *)(long)i);
+    v2_json_unref(&maker);
+    for(i=0; i<RF_THREADS; i++) pthread_join(thr[i], NULL);
+    if(rf_shared->cnt != 1) rf_fail("thread owners are not dropped", -1, -1);
+    v2_json_free_box(keep);
+    free(keep);
+
+    printf("refs: %d orders, %d threads: %s\n", rf_orders, RF_THREADS, rf_bad ? "FAILED" : "ok");
+    return(rf_bad ? 1 : 0);
+}
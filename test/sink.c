@@ -0,0 +1,271 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Streamed text is the same as v2_json_text() one in buffer:
+ *   - v2_json_sink() to a callback, v2_json_write() to a file descriptor, v2_json_fwrite() to a file,
+ *     with flush thresholds from 1 byte to default, for every ident/no_escape pair
+ *   - writev() is replaced here: it writes random parts of vectors and fails by EINTR now and then,
+ *     so v2_wrbuf_emit() has to go on from the middle of its vectors
+ *   - v2_wrbuf_putn() of sfl bytes or more goes to sink by one call, after buffered data
+ *   - sink failed once gets no more data: v2_json_sink() gives 17380, v2_wrbuf_flush() 14940
+ *
+ * Usage: sink
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "doc.h"
+#include "v2_jsmn.h"
+
+static int sk_bad=0;
+static int sk_texts=0;
+static int sk_short=0;          // writev() writes parts
+static unsigned int sk_seed=23;
+static long sk_parts=0;         // Partial writev() calls
+static long sk_intr=0;          // writev() calls failed by EINTR
+
+typedef struct {
+    wrbuf_t b;       // All it got
+    size_t calls;    // Sink calls
+    size_t last;     // Bytes of last call
+    size_t fail_at;  // Not 0 - bytes it takes, short write after
+    size_t failed;   // calls when it failed
+} sk_out_t;
+
+/* ========================================================================= */
+static void sk_fail(const char *in_what, const char *in_doc, size_t in_flush) {
+
+    if(sk_bad++ < 10) printf("FAIL %s, %s, flush %zu\n", in_what, in_doc, in_flush);
+}
+/* ========================================================================= */
+// Part of vectors only - the rest is for next call
+ssize_t writev(int in_fd, const struct iovec *in_iov, int in_cnt) {
+    size_t all=0;
+    size_t lim=0;
+    size_t out=0;
+    size_t n=0;
+    ssize_t rc=0;
+    int i=0;
+
+    for(i=0; i<in_cnt; i++) all+=in_iov[i].iov_len;
+    lim=all;
+
+    if(sk_short && all) {
+	if(td_rand(&sk_seed) % 8 == 0) {
+	    sk_intr++;
+	    errno=EINTR;
+	    return(-1);
+	}
+	lim=1 + td_rand(&sk_seed) % all;
+	if(lim < all) sk_parts++;
+    }
+
+    for(i=0; i<in_cnt && out<lim; i++) {
+	n=(in_iov[i].iov_len < lim-out) ? in_iov[i].iov_len : lim-out;
+	if((rc=write(in_fd, in_iov[i].iov_base, n)) < 0) return(out ? (ssize_t)out : -1);
+	out+=rc;
+	if((size_t)rc < n) break;
+    }
+    return(out);
+}
+/* ========================================================================= */
+static size_t sk_collect(void *in_data, const char *in_buf, size_t in_len) {
+    sk_out_t *o=(sk_out_t *)in_data;
+    size_t len=in_len;
+
+    o->calls++;
+    o->last=in_len;
+
+    if(o->fail_at && o->b.cnt+len > o->fail_at) { // Takes a part - error
+	len=o->fail_at-o->b.cnt;
+	if(!o->failed) o->failed=o->calls;
+    }
+    if(len) v2_wrbuf_putn(&o->b, in_buf, len);
+    return(len);
+}
+/* ========================================================================= */
+// File text has to be in_ref
+static int sk_file_cmp(FILE *in_file, const char *in_ref, size_t in_len) {
+    char buf[4096];
+    size_t off=0;
+    size_t n=0;
+
+    fflush(in_file);
+    rewind(in_file);
+    while((n=fread(buf, 1, sizeof(buf), in_file))) {
+	if(off+n > in_len || memcmp(buf, in_ref+off, n)) return(1);
+	off+=n;
+    }
+    rewind(in_file);
+    if(ftruncate(fileno(in_file), 0)) return(1);
+
+    return(off != in_len);
+}
+/* ========================================================================= */
+// Every sink and flush threshold against text in buffer
+static void sk_box(json_box_t *in_jbox, const char *in_doc) {
+    static const size_t flush[]={1, 7, 64, 1000, 0};
+    FILE *file=tmpfile();
+    sk_out_t o;
+    char *ref=NULL;
+    size_t len=0;
+    size_t f=0;
+    int fd=-1;
+    int rc=0;
+
+    in_jbox->keep_text=0;
+    in_jbox->no_clean=0;
+    v2_wrbuf_new(&in_jbox->b);
+    if(v2_json_text(in_jbox) || !in_jbox->b->buf) {
+	sk_fail("v2_json_text() failed", in_doc, 0);
+	return;
+    }
+    len=in_jbox->b->cnt;
+    ref=(char *)malloc(len);
+    memcpy(ref, in_jbox->b->buf, len);
+
+    for(f=0; f<sizeof(flush)/sizeof(flush[0]); f++) {
+	memset(&o, 0, sizeof(o));
+	if((rc=v2_json_sink(in_jbox, sk_collect, &o, flush[f])) || o.b.cnt != len || memcmp(o.b.buf, ref, len)) sk_fail("v2_json_sink() text differs", in_doc, flush[f]);
+
+	// Sink fails in the middle - nothing after
+	v2_wrbuf_reset(&o.b);
+	o.calls=o.failed=0;
+	o.fail_at=len/2;
+	if(v2_json_sink(in_jbox, sk_collect, &o, flush[f]) != 17380) sk_fail("failed sink is not reported", in_doc, flush[f]);
+	if(o.calls != o.failed || o.b.cnt != len/2) sk_fail("failed sink got more data", in_doc, flush[f]);
+	v2_wrbuf_reset(&o.b);
+
+	sk_short=1;
+	if(v2_json_write(in_jbox, fileno(file), flush[f]) || sk_file_cmp(file, ref, len)) sk_fail("v2_json_write() text differs", in_doc, flush[f]);
+	sk_short=0;
+
+	if(v2_json_fwrite(in_jbox, file, flush[f]) || sk_file_cmp(file, ref, len)) sk_fail("v2_json_fwrite() text differs", in_doc, flush[f]);
+	sk_texts++;
+    }
+
+    if((fd=dup(fileno(file))) >= 0) { // Closed one
+	close(fd);
+	if(v2_json_write(in_jbox, fd, 64) != 17380) sk_fail("failed write() is not reported", in_doc, 64);
+    }
+
+    fclose(file);
+    free(ref);
+}
+/* ========================================================================= */
+// Random puts straight to wrbuf: big ones go by one sink call
+static void sk_puts(void) {
+    static const char fill[]="0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    char piece[400];
+    wrbuf_t *ref=NULL;
+    wrbuf_t w;
+    sk_out_t o;
+    size_t len=0;
+    size_t i=0;
+    int k=0;
+
+    memset(&o, 0, sizeof(o));
+    v2_wrbuf_new(&ref);
+    v2_wrbuf_init(&w);
+    v2_wrbuf_sink(&w, sk_collect, &o, 100);
+
+    for(k=0; k<5000; k++) {
+	len=td_rand(&sk_seed) % sizeof(piece);
+	for(i=0; i<len; i++) piece[i]=fill[(k+i) % (sizeof(fill)-1)];
+
+	switch(td_rand(&sk_seed) % 4) {
+	case 0:
+	    v2_wrbuf_putc(&w, piece[0]);
+	    v2_wrbuf_putc(ref, piece[0]);
+	    break;
+	case 1:
+	    v2_wrbuf_put_spaces(&w, len % 150);
+	    v2_wrbuf_put_spaces(ref, len % 150);
+	    break;
+	default:
+	    v2_wrbuf_putn(&w, piece, len);
+	    v2_wrbuf_putn(ref, piece, len);
+	    if(len >= 100 && (o.last != len || w.cnt)) sk_fail("big put is not one sink call", "puts", 100);
+	    break;
+	}
+    }
+    if(v2_wrbuf_flush(&w) || w.sout != ref->cnt || o.b.cnt != ref->cnt || memcmp(o.b.buf, ref->buf, ref->cnt)) sk_fail("text differs", "puts", 100);
+
+    // Failed sink is latched
+    o.fail_at=o.b.cnt+10;
+    o.failed=0;
+    v2_wrbuf_putn(&w, fill, 50);
+    if(v2_wrbuf_flush(&w) != 14940 || !w.serr) sk_fail("failed flush is not reported", "puts", 100);
+    len=o.calls;
+    v2_wrbuf_putn(&w, fill, 20);
+    v2_wrbuf_putn(&w, piece, sizeof(piece));
+    if(v2_wrbuf_flush(&w) != 14940 || o.calls != len) sk_fail("failed sink got more data", "puts", 100);
+
+    v2_wrbuf_reset(&w);
+    v2_wrbuf_reset(&o.b);
+    v2_wrbuf_free(&ref);
+}
+/* ========================================================================= */
+int main(int argc, char *argv[]) {
+    static const int kinds[]={TD_MIX, TD_STRINGS, TD_RECORDS};
+    static const char *names[]={"mix", "strings", "records"};
+    static const int idents[]={0, 4};
+    v2_jsmn_t jsmn;
+    size_t len=0;
+    char *js=NULL;
+    char name[64];
+    int k=0, i=0, e=0;
+
+    sk_puts();
+
+    for(k=0; k<3; k++) {
+	memset(&jsmn, 0, sizeof(jsmn));
+	js=td_doc(kinds[k], 30+k, 60000, &len);
+	v2_wrbuf_new(&jsmn.b);
+	v2_wrbuf_write(jsmn.b, js, 1, len);
+	if(v2_jsmn_parse(&jsmn) || !jsmn.box) {
+	    sk_fail("parse failed", names[k], 0);
+	} else {
+	    for(i=0; i<2; i++) {
+		for(e=0; e<3; e++) {
+		    snprintf(name, sizeof(name), "%s, ident %d, no_escape %d", names[k], idents[i], e);
+		    jsmn.box->ident=idents[i];
+		    jsmn.box->no_escape=e;
+		    sk_box(jsmn.box, name);
+		}
+	    }
+	}
+	if(jsmn.box) {
+	    v2_json_free_box(jsmn.box);
+	    free(jsmn.box);
+	}
+	v2_jsmn_init(&jsmn);
+	v2_wrbuf_free(&jsmn.b);
+	free(js);
+    }
+
+    if(!sk_parts || !sk_intr) sk_fail("writev() was not cut", "all", 0);
+
+    printf("sink: %d texts, %ld partial and %ld interrupted writev(): %s\n", sk_texts, sk_parts, sk_intr, sk_bad ? "FAILED" : "ok");
+    return(sk_bad ? 1 : 0);
+}
@@ -0,0 +1,191 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Parsers of different threads do not share state:
+ *   - ST_THREADS threads parse different documents by own v2_jsmn_t, with every backend, by chunks,
+ *     lazy and with builder threads - trees and v2_jsmn_get_str() values are the same as serial ones
+ *   - "_array_NNNN" names (v2_jsmn_t.none) are counted per parser - they are in printed trees
+ *   - errors and warnings of all threads are in v2_err_lst, none is lost
+ *   - v2_sidx_level() is asked first by all threads at once and gives one level
+ * Run it by ThreadSanitizer too: make stress
+ *
+ * Usage: stress [iterations per thread (40)]
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "doc.h"
+#include "v2_jsmn.h"
+#include "v2_err.h"
+
+#define ST_THREADS 8
+#define ST_DOCS    12
+#define ST_WAYS    6 // Tape, jsmn, sidx, chunks, lazy, builder threads
+
+typedef struct {
+    char *js;    // Text
+    size_t len;
+    char *path;  // Value for v2_jsmn_get_str()
+    char *tree;  // Serial tree text, NULL - parse error
+    char val[64];
+    int rc;      // Serial parse rc
+} st_doc_t;
+
+static st_doc_t st_doc[ST_DOCS];
+static int st_iter=40;
+static int st_bad=0;
+static int st_level[ST_THREADS];
+static pthread_barrier_t st_ready;
+
+/* ========================================================================= */
+static void st_fail(const char *in_what, int in_doc, int in_way) {
+
+    if(__sync_fetch_and_add(&st_bad, 1) < 10) printf("FAIL %s, document %d, way %d\n", in_what, in_doc, in_way);
+}
+/* ========================================================================= */
+// Parse document in_doc by in_way, tree text to *p_tree (malloc()-ed), value of path to out_val
+static int st_parse(int in_doc, int in_way, char **p_tree, char *out_val, size_t in_size) {
+    st_doc_t *doc=&st_doc[in_doc];
+    v2_jsmn_t jsmn;
+    size_t x=0;
+    int rc=0;
+
+    memset(&jsmn, 0, sizeof(jsmn));
+    *p_tree=NULL;
+    out_val[0]='\0';
+
+    jsmn.backend=(in_way <= V2_JSMN_BACK_SIDX)?in_way:V2_JSMN_BACK_TAPE;
+    jsmn.lazy=(in_way == 4);
+    jsmn.threads=(in_way == 5)?4:0;
+    v2_wrbuf_new(&jsmn.b);
+
+    if(in_way == 3) {
+	for(x=0; x<doc->len && !rc; x+=4093) rc=v2_jsmn_feed(&jsmn, doc->js+x, (doc->len-x < 4093)?doc->len-x:4093);
+	if(!rc) rc=v2_jsmn_finish(&jsmn);
+    } else {
+	v2_wrbuf_write(jsmn.b, doc->js, 1, doc->len);
+	rc=v2_jsmn_parse(&jsmn);
+    }
+
+    if(!rc && doc->path && !v2_jsmn_get_str(&jsmn, doc->path, out_val, in_size)) out_val[0]='\0';
+
+    if(!rc && jsmn.box) {
+	jsmn.box->ident=0;
+	jsmn.box->no_escape=0;
+	v2_wrbuf_new(&jsmn.box->b);
+	v2_json_text(jsmn.box);
+	*p_tree=strdup(jsmn.box->b->buf ? jsmn.box->b->buf : "");
+    }
+
+    if(jsmn.box) {
+	v2_json_free_box(jsmn.box);
+	free(jsmn.box);
+    }
+    v2_jsmn_init(&jsmn);
+    v2_wrbuf_free(&jsmn.b);
+
+    return(rc);
+}
+/* ========================================================================= */
+static void *st_run(void *in_arg) {
+    long id=(long)in_arg;
+    char val[64];
+    char *tree=NULL;
+    int doc=0;
+    int way=0;
+    int rc=0;
+    int i=0;
+
+    st_level[id]=v2_sidx_level(); // All at once - first call
+    pthread_barrier_wait(&st_ready);
+
+    for(i=0; i<st_iter; i++) {
+	doc=(id+i) % ST_DOCS; // Different ones at once, every way for every document by some thread
+	way=((id+i)/ST_DOCS+id) % ST_WAYS;
+
+	rc=st_parse(doc, way, &tree, val, sizeof(val));
+	if(rc != st_doc[doc].rc) st_fail("rc differs", doc, way);
+	else if(way != 4 && st_doc[doc].tree && (!tree || strcmp(tree, st_doc[doc].tree))) st_fail("tree differs", doc, way);
+	else if(strcmp(val, st_doc[doc].val)) st_fail("value differs", doc, way);
+	free(tree);
+
+	v2_add_warn("stress: thread %ld, step %d", id, i);
+    }
+    return(NULL);
+}
+/* ========================================================================= */
+int main(int argc, char *argv[]) {
+    static const int kinds[]={TD_MIX, TD_RECORDS, TD_STRINGS, TD_NUMBERS};
+    pthread_t thr[ST_THREADS];
+    str_lst_t *err=NULL;
+    st_doc_t *doc=NULL;
+    int warn=0;
+    int kind=0;
+    int d=0;
+    long i=0;
+
+    if(argc > 1) st_iter=atoi(argv[1]);
+    pthread_barrier_init(&st_ready, NULL, ST_THREADS+1);
+    v2_del_error();
+
+    // Threads ask v2_sidx_level() while documents are made
+    for(i=0; i<ST_THREADS; i++) {
+	if(pthread_create(&thr[i], NULL, st_run, (void *)i)) {
+	    printf("FAIL can not start thread\n");
+	    return(1);
+	}
+    }
+
+    for(d=0; d<ST_DOCS; d++) {
+	doc=&st_doc[d];
+	kind=(d == ST_DOCS-2)?TD_RECORDS:kinds[d % 4];
+	if(d == ST_DOCS-1) { // Not json - error by every thread
+	    doc->js=strdup("not json at all");
+	    doc->len=strlen(doc->js);
+	} else {
+	    doc->js=td_doc(kind, d+1, (d == ST_DOCS-2)?1 << 20:2000+d*3000, &doc->len); // Last one is big enough for builder threads
+	    if(kind == TD_RECORDS) doc->path="3.name";
+	    if(kind == TD_STRINGS) doc->path="s2";
+	}
+	doc->rc=st_parse(d, V2_JSMN_BACK_JSMN, &doc->tree, doc->val, sizeof(doc->val));
+    }
+    pthread_barrier_wait(&st_ready);
+
+    for(i=0; i<ST_THREADS; i++) pthread_join(thr[i], NULL);
+
+    for(i=0; i<ST_THREADS; i++) {
+	if(st_level[i] != v2_sidx_level()) st_fail("v2_sidx_level() differs", -1, (int)i);
+    }
+    FOR_LST(err, v2_err_lst) {
+	if(err->key && !strncmp(err->key, "stress: ", 8)) warn++;
+    }
+    if(warn != ST_THREADS*st_iter) st_fail("warnings lost", warn, ST_THREADS*st_iter);
+
+    for(d=0; d<ST_DOCS; d++) {
+	free(st_doc[d].js);
+	free(st_doc[d].tree);
+    }
+    v2_del_error();
+    pthread_barrier_destroy(&st_ready);
+
+    printf("stress: %d threads, %d parses, %d warnings: %s\n", ST_THREADS, ST_THREADS*st_iter, warn, st_bad ? "FAILED" : "ok");
+    return(st_bad ? 1 : 0);
+}
@@ -0,0 +1,374 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Tokenizer backends give the same result:
+ *   - v2_sidx_parse() tokens at every stage 1 level are the same as jsmn_parse() ones
+ *   - v2_sidx_tape() words match jsmn_parse() tokens one by one
+ *   - trees built by V2_JSMN_BACK_TAPE, _JSMN and _SIDX print the same text
+ * Broken and truncated text has to come back as V2_SIDX_SLOW, so v2_jsmn falls back to jsmn_parse().
+ *
+ * Usage: tokens [file.json ...] - files are checked before generated documents
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "doc.h"
+#include "v2_jsmn.h"
+
+static int tk_bad=0;   // Failed checks
+static int tk_docs=0;  // Checked documents
+static int tk_slow=0;  // Not json for stage 2 - jsmn_parse() decides
+
+static jsmntok_t *tk_ref=NULL; // jsmn_parse() tokens
+static int tk_rmax=0;
+static jsmntok_t *tk_tok=NULL; // v2_sidx_parse() tokens
+static int tk_tmax=0;
+
+/* ========================================================================= */
+static void tk_fail(const char *in_what, const char *in_js, size_t in_len, int in_level) {
+
+    if(tk_bad++ < 10) printf("FAIL %s, level %d, %zu bytes: %.*s\n", in_what, in_level, in_len, (int)(in_len < 200 ? in_len : 200), in_js);
+}
+/* ========================================================================= */
+// Reference tokens by fresh jsmn parser
+static int tk_jsmn(const char *in_js, size_t in_len) {
+    jsmn_parser parser;
+    int cnt=0;
+
+    if(!tk_rmax) tk_ref=(jsmntok_t *)malloc((tk_rmax=256)*sizeof(jsmntok_t));
+    jsmn_init(&parser);
+    while((cnt=jsmn_parse(&parser, in_js, in_len, tk_ref, tk_rmax)) == JSMN_ERROR_NOMEM) {
+	tk_rmax*=2;
+	tk_ref=(jsmntok_t *)realloc(tk_ref, tk_rmax*sizeof(jsmntok_t));
+    }
+    return(cnt);
+}
+/* ========================================================================= */
+// Elements of container at tape word in_x
+static int tk_tape_size(v2_tape_t *in_tape, size_t in_x) {
+    size_t end=V2_TAPE_VAL(in_tape->w[in_x]);
+    size_t y=in_x+1;
+    char type=0;
+    int cnt=0;
+
+    while(y < end) {
+	type=V2_TAPE_TYPE(in_tape->w[y]);
+	if(type == 'k') { y++; continue; } // Member name counts with its value
+	if(type == '{' || type == '[') y=V2_TAPE_VAL(in_tape->w[y]);
+	y++;
+	cnt++;
+    }
+    return(cnt);
+}
+/* ========================================================================= */
+// Tape words against in_cnt reference tokens, 0 - the same
+static int tk_tape_cmp(const char *in_js, size_t in_len, v2_tape_t *in_tape, int in_cnt) {
+    jsmntok_t *tok=NULL;
+    uint64_t w=0;
+    size_t x=0;
+    int t=0;
+
+    for(x=0; x<in_tape->cnt; x++) {
+	w=in_tape->w[x];
+
+	switch(V2_TAPE_TYPE(w)) {
+	case '}':
+	case ']': // Close points to its open, open to its close
+	    if(V2_TAPE_VAL(in_tape->w[V2_TAPE_VAL(w)]) != x) return(1);
+	    continue;
+	}
+
+	if(t >= in_cnt) return(2);
+	tok=&tk_ref[t++];
+
+	switch(V2_TAPE_TYPE(w)) {
+	case '{':
+	case '[':
+	    if(tok->type != (V2_TAPE_TYPE(w) == '{' ? JSMN_OBJECT : JSMN_ARRAY)) return(3);
+	    if(in_js[tok->start] != V2_TAPE_TYPE(w)) return(4);
+	    if(tok->size != tk_tape_size(in_tape, x)) return(5);
+	    break;
+	case 'k':
+	case '"':
+	    if(tok->type != JSMN_STRING) return(6);
+	    if(tok->size != (V2_TAPE_TYPE(w) == 'k')) return(7);
+	    if(V2_TAPE_ESC(w) != (memchr(in_js+tok->start, '\\', tok->end-tok->start) != NULL)) return(8);
+	    // fall through
+	case 'p':
+	    if(V2_TAPE_TYPE(w) == 'p' && tok->type != JSMN_PRIMITIVE) return(9);
+	    if(V2_TAPE_VAL(w) != (size_t)tok->start) return(10);
+	    if(v2_tape_len(in_js, in_len, w) != (size_t)(tok->end-tok->start)) return(11);
+	    break;
+	default:
+	    return(12);
+	}
+    }
+    return(t != in_cnt ? 13 : 0);
+}
+/* ========================================================================= */
+// Both v2_sidx_*() at every level against jsmn_parse(), is_json - text is strict json, no V2_SIDX_SLOW is expected
+static void tk_tokens(const char *in_js, size_t in_len, int is_json) {
+    v2_tape_t tape;
+    int cnt=tk_jsmn(in_js, in_len);
+    int level=0;
+    int rc=0;
+    int x=0;
+
+    memset(&tape, 0, sizeof(tape));
+
+    for(level=V2_SIDX_SCALAR; level<=v2_sidx_level(); level++) {
+	rc=v2_sidx_parse(level, in_js, in_len, &tk_tok, &tk_tmax);
+	if(rc == V2_SIDX_SLOW) {
+	    if(is_json) tk_fail("tokens slow on json", in_js, in_len, level);
+	    tk_slow++;
+	} else if(rc != cnt) {
+	    tk_fail("tokens count", in_js, in_len, level);
+	} else {
+	    for(x=0; x<cnt; x++) {
+		if(tk_tok[x].type != tk_ref[x].type || tk_tok[x].start != tk_ref[x].start ||
+		   tk_tok[x].end  != tk_ref[x].end  || tk_tok[x].size  != tk_ref[x].size) break;
+	    }
+	    if(x < cnt) tk_fail("tokens differ", in_js, in_len, level);
+	}
+
+	rc=v2_sidx_tape(level, in_js, in_len, &tape);
+	if(rc == V2_SIDX_SLOW) {
+	    if(is_json) tk_fail("tape slow on json", in_js, in_len, level);
+	} else if(rc || cnt < 0 || tk_tape_cmp(in_js, in_len, &tape, cnt)) {
+	    tk_fail("tape differs", in_js, in_len, level);
+	}
+    }
+
+    v2_tape_free(&tape);
+    tk_docs++;
+}
+/* ========================================================================= */
+// Text of tree built by in_backend, in_rc - parse result
+static char *tk_tree(const char *in_js, size_t in_len, int in_backend, int *p_rc) {
+    v2_jsmn_t jsmn;
+    char *out=NULL;
+
+    memset(&jsmn, 0, sizeof(jsmn));
+    jsmn.backend=in_backend;
+
+    v2_wrbuf_new(&jsmn.b);
+    v2_wrbuf_write(jsmn.b, (char *)in_js, 1, in_len);
+
+    if(!(*p_rc=v2_jsmn_parse(&jsmn)) && jsmn.box) {
+	jsmn.box->ident=0;
+	jsmn.box->no_escape=0;
+	v2_wrbuf_new(&jsmn.box->b);
+	v2_json_text(jsmn.box);
+	out=strdup(jsmn.box->b->buf ? jsmn.box->b->buf : "");
+    }
+
+    if(jsmn.box) {
+	v2_json_free_box(jsmn.box);
+	free(jsmn.box);
+    }
+    v2_jsmn_init(&jsmn);
+    v2_wrbuf_free(&jsmn.b);
+
+    return(out);
+}
+/* ========================================================================= */
+// The same tree (or error) by every backend
+static void tk_trees(const char *in_js, size_t in_len) {
+    char *ref=NULL;
+    char *out=NULL;
+    int rc_ref=0;
+    int rc=0;
+    int back=0;
+
+    ref=tk_tree(in_js, in_len, V2_JSMN_BACK_JSMN, &rc_ref);
+    for(back=V2_JSMN_BACK_TAPE; back<=V2_JSMN_BACK_SIDX; back++) {
+	if(back == V2_JSMN_BACK_JSMN) continue;
+	out=tk_tree(in_js, in_len, back, &rc);
+	if(rc != rc_ref || (ref && (!out || strcmp(ref, out))) || (!ref && out)) tk_fail("tree differs", in_js, in_len, -back);
+	free(out);
+    }
+    free(ref);
+}
+/* ========================================================================= */
+// Every shorter part of the text: it is not json any more - stage 2 has to give up, parse errors are the same
+static void tk_truncated(const char *in_js, size_t in_len, int is_tree) {
+    char *part=(char *)malloc(in_len+1);
+    v2_tape_t tape;
+    size_t len=0;
+    int level=0;
+
+    memset(&tape, 0, sizeof(tape));
+
+    for(len=1; len<in_len; len++) {
+	memcpy(part, in_js, len);
+	part[len]='\0';
+
+	for(level=V2_SIDX_SCALAR; level<=v2_sidx_level(); level++) {
+	    if(v2_sidx_parse(level, part, len, &tk_tok, &tk_tmax) != V2_SIDX_SLOW) tk_fail("truncated tokens not slow", part, len, level);
+	    if(v2_sidx_tape(level, part, len, &tape) != V2_SIDX_SLOW)               tk_fail("truncated tape not slow", part, len, level);
+	}
+	if(is_tree) tk_trees(part, len);
+    }
+
+    v2_tape_free(&tape);
+    free(part);
+}
+/* ========================================================================= */
+// Backslash runs of 1..6 bytes at every offset of 16, 32 and 64 bytes blocks - in values and in member names
+static void tk_escapes(void) {
+    char js[512];
+    char str[256];
+    size_t len=0;
+    int pad=0;
+    int run=0;
+    int end=0;
+    int x=0;
+
+    for(pad=0; pad<140; pad++) {
+	for(run=1; run<=6; run++) {
+	    for(end=0; end<2; end++) {
+		len=0;
+		for(x=0; x<pad; x++) str[len++]='a';
+		for(x=0; x<run; x++) str[len++]='\\';
+		if(run & 1) str[len++]='"'; // Odd run - quote is escaped
+		if(!end) for(x=0; x<3; x++) str[len++]='z'; // Even run at the very end - before closing quote
+		str[len]='\0';
+
+		len=snprintf(js, sizeof(js), "[\"%s\",{\"%s\":%d}]", str, str, pad);
+		tk_tokens(js, len, 1);
+		tk_trees(js, len);
+		if(!(pad % 16)) tk_truncated(js, len, 0);
+	    }
+	}
+    }
+}
+/* ========================================================================= */
+// Random bytes of json alphabet - mostly broken, must be slow or the same as jsmn_parse()
+static void tk_noise(int in_num) {
+    const char *alpha="{}[]:,\"\\ \t\nab1.-tu0\"\"\\";
+    unsigned int seed=7;
+    char js[300];
+    size_t len=0;
+    size_t x=0;
+    int i=0;
+
+    for(i=0; i<in_num; i++) {
+	len=td_rand(&seed)%sizeof(js);
+	for(x=0; x<len; x++) js[x]=alpha[td_rand(&seed)%strlen(alpha)];
+	if(len > 2 && !(td_rand(&seed)%3)) js[0]='[';
+	js[len]='\0';
+	tk_tokens(js, len, 0);
+    }
+}
+/* ========================================================================= */
+// Member names longer than MAX_STRING_LEN, escaped and plain, are kept whole by every builder, feed and lazy get
+static void tk_names(void) {
+    wrbuf_t *b=NULL;
+    char *esc=(char *)malloc(3*MAX_STRING_LEN);
+    char *name=(char *)malloc(3*MAX_STRING_LEN);
+    char *path=(char *)malloc(6*MAX_STRING_LEN);
+    char str[16];
+    v2_jsmn_t jsmn;
+    json_lst_t *json=NULL;
+    size_t x=0;
+    int back=0;
+    int rc=0;
+
+    for(x=0; x<2*MAX_STRING_LEN; x++) esc[x]='a'+x%26;
+    esc[x]='\0';
+    memcpy(esc, "\\u0416", 6); // Escaped: "\u0416ghij..." is "Жghij..."
+    snprintf(name, 3*MAX_STRING_LEN, "\xd0\x96%s", esc+6);
+    snprintf(path, 6*MAX_STRING_LEN, "%s.%s", name, esc+6); // Second one is plain
+
+    v2_wrbuf_new(&b);
+    v2_wrbuf_printf(b, "{\"%s\": {\"%s\": \"v\"}, \"%s\": [1]}", esc, esc+6, esc+6);
+    tk_trees(b->buf, b->cnt);
+
+    for(back=V2_JSMN_BACK_TAPE; back<=V2_JSMN_BACK_SIDX+2; back++) { // +1 - fed by chunks, +2 - lazy
+	memset(&jsmn, 0, sizeof(jsmn));
+	jsmn.backend=(back > V2_JSMN_BACK_SIDX)?V2_JSMN_BACK_TAPE:back;
+	jsmn.lazy=(back == V2_JSMN_BACK_SIDX+2);
+	v2_wrbuf_new(&jsmn.b);
+	if(back == V2_JSMN_BACK_SIDX+1) {
+	    for(x=0; x<b->cnt && !rc; x+=100) rc=v2_jsmn_feed(&jsmn, b->buf+x, (b->cnt-x < 100)?b->cnt-x:100);
+	    if(!rc) rc=v2_jsmn_finish(&jsmn);
+	} else {
+	    v2_wrbuf_write(jsmn.b, b->buf, 1, b->cnt);
+	    rc=v2_jsmn_parse(&jsmn);
+	}
+
+	if(rc) tk_fail("long names parse", b->buf, b->cnt, -back);
+	else if(jsmn.lazy && (!v2_jsmn_get_str(&jsmn, path, str, sizeof(str)) || strcmp(str, "v"))) tk_fail("long names lazy get", b->buf, b->cnt, -back);
+	else if(!jsmn.lazy && (!(json=v2_json_find(jsmn.box, path)) || strcmp(v2_json_value(jsmn.box, json), "v"))) tk_fail("long names find", b->buf, b->cnt, -back);
+	tk_docs++;
+
+	if(jsmn.box) {
+	    v2_json_free_box(jsmn.box);
+	    free(jsmn.box);
+	}
+	v2_jsmn_init(&jsmn);
+	v2_wrbuf_free(&jsmn.b);
+    }
+
+    v2_wrbuf_free(&b);
+    free(path);
+    free(name);
+    free(esc);
+}
+/* ========================================================================= */
+int main(int argc, char *argv[]) {
+    static const int kinds[]={TD_MIX, TD_RECORDS, TD_NUMBERS, TD_STRINGS};
+    char *js=NULL;
+    size_t len=0;
+    unsigned int seed=0;
+    int i=0;
+
+    for(i=1; i<argc; i++) { // Sample files
+	if(!(js=td_file(argv[i], &len))) {
+	    printf("FAIL can not read %s\n", argv[i]);
+	    return(1);
+	}
+	tk_tokens(js, len, 1);
+	tk_trees(js, len);
+	free(js);
+    }
+
+    for(seed=1; seed<=400; seed++) { // Generated documents of every kind and size
+	js=td_doc(kinds[seed % 4], seed, (seed*37) % 20000, &len);
+	tk_tokens(js, len, 1);
+	tk_trees(js, len);
+	if(seed <= 20) tk_truncated(js, len < 600 ? len : 600, 1);
+	free(js);
+    }
+    js=td_doc(TD_DEEP, 1, 300, &len);
+    tk_tokens(js, len, 1);
+    tk_trees(js, len);
+    free(js);
+
+    tk_escapes();
+    tk_names();
+    tk_noise(100000);
+
+    free(tk_ref);
+    free(tk_tok);
+
+    printf("tokens: %d texts (%d slow), levels 1..%d: %s\n", tk_docs, tk_slow, v2_sidx_level(), tk_bad ? "FAILED" : "ok");
+    return(tk_bad ? 1 : 0);
+}
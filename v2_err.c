@@ -16,11 +16,15 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <pthread.h>
+
 #include "v2_err.h"
 
 str_lst_t *v2_err_lst=NULL;
 int (*v2_hook_error)(str_lst_t *err_rec)=NULL;
 
+static pthread_mutex_t v2_err_mutex=PTHREAD_MUTEX_INITIALIZER; // Errors list is one for all threads
+
 /* ======================================================================= */
 // Error functions
 /* ======================================================================= */
@@ -60,12 +64,16 @@ int v2_add_err(int err, int level, char *err_msg) {
 
     if(!v2_strcmp(err_msg, "-")) return(v2_del_error()); // Reset all error list
 
-    err_tmp=v2_add_lstr_tail(&v2_err_lst, err_msg, NULL, time(NULL), level);
-    err_tmp->num=err;
+    pthread_mutex_lock(&v2_err_mutex);
 
-    if(v2_hook_error) v2_hook_error(err_tmp);
+    if((err_tmp=v2_add_lstr_tail(&v2_err_lst, err_msg, NULL, time(NULL), level))) {
+	err_tmp->num=err;
+	if(v2_hook_error) v2_hook_error(err_tmp);
+    }
 
-    return(err_tmp->num);
+    pthread_mutex_unlock(&v2_err_mutex);
+
+    return(err);
 }
 /* ======================================================================= */
 int v2_add_error(char *err_form, ...) {
@@ -99,7 +107,9 @@ int v2_add_debug(int level, char *err_form, ...) {
 /* ======================================================================= */
 // Delete all errors into list
 int v2_del_error(void) {
+    pthread_mutex_lock(&v2_err_mutex);
     v2_lstr_free(&v2_err_lst);
+    pthread_mutex_unlock(&v2_err_mutex);
     return(0);
 }
 /* ======================================================================= */
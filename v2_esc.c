@@ -0,0 +1,201 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "v2_esc.h"
+#include "v2_sidx.h" // v2_sidx_level()
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define VE_X86 1
+#include <immintrin.h>
+#endif
+
+// First not clean byte from in_p, in_end if none
+typedef const unsigned char *(*ve_scan_f)(const unsigned char *in_p, const unsigned char *in_end, int in_mode);
+
+// u8_nextchar() offsets by sequence length
+static const uint32_t ve_utf8_off[6] = {
+    0x00000000UL, 0x00003080UL, 0x000E2080UL,
+    0x03C82080UL, 0xFA082080UL, 0x82082080UL
+};
+
+static const char ve_hex[16] = "0123456789ABCDEF";
+
+/* ========================================================================= */
+// Byte is copied as is in in_mode
+static int ve_clean(unsigned char in_c, int in_mode) {
+
+    if(in_mode == V2_ESC_QUOTES) return(in_c != '"');
+    return(in_c >= 0x20 && in_c < 0x7F && in_c != '"' && in_c != '\\');
+}
+/* ========================================================================= */
+static const unsigned char *ve_scan_scalar(const unsigned char *in_p, const unsigned char *in_end, int in_mode) {
+
+    while(in_p < in_end && ve_clean(*in_p, in_mode)) in_p++;
+    return(in_p);
+}
+#ifdef VE_X86
+/* ========================================================================= */
+static const unsigned char *ve_scan_sse2(const unsigned char *in_p, const unsigned char *in_end, int in_mode) {
+    const __m128i c_quote = _mm_set1_epi8('"');
+    const __m128i c_bs    = _mm_set1_epi8('\\');
+    const __m128i c_20    = _mm_set1_epi8(0x20);
+    const __m128i c_7f    = _mm_set1_epi8(0x7F);
+    __m128i v, m;
+    int bits=0;
+
+    for(; in_p+16 <= in_end; in_p+=16) {
+	v=_mm_loadu_si128((const __m128i *)in_p);
+	m=_mm_cmpeq_epi8(v, c_quote);
+	if(in_mode != V2_ESC_QUOTES) { // Signed compare - bytes 0x80-0xFF are below 0x20 too
+	    m=_mm_or_si128(_mm_or_si128(m, _mm_cmpeq_epi8(v, c_bs)),
+			   _mm_or_si128(_mm_cmplt_epi8(v, c_20), _mm_cmpeq_epi8(v, c_7f)));
+	}
+	if((bits=_mm_movemask_epi8(m))) return(in_p+__builtin_ctz(bits));
+    }
+    return(ve_scan_scalar(in_p, in_end, in_mode));
+}
+/* ========================================================================= */
+__attribute__((target("avx2")))
+static const unsigned char *ve_scan_avx2(const unsigned char *in_p, const unsigned char *in_end, int in_mode) {
+    const __m256i c_quote = _mm256_set1_epi8('"');
+    const __m256i c_bs    = _mm256_set1_epi8('\\');
+    const __m256i c_20    = _mm256_set1_epi8(0x20);
+    const __m256i c_7f    = _mm256_set1_epi8(0x7F);
+    __m256i v, m;
+    unsigned int bits=0;
+
+    for(; in_p+32 <= in_end; in_p+=32) {
+	v=_mm256_loadu_si256((const __m256i *)in_p);
+	m=_mm256_cmpeq_epi8(v, c_quote);
+	if(in_mode != V2_ESC_QUOTES) { // Signed: 0x20 > byte for controls and 0x80-0xFF
+	    m=_mm256_or_si256(_mm256_or_si256(m, _mm256_cmpeq_epi8(v, c_bs)),
+			      _mm256_or_si256(_mm256_cmpgt_epi8(c_20, v), _mm256_cmpeq_epi8(v, c_7f)));
+	}
+	if((bits=(unsigned int)_mm256_movemask_epi8(m))) return(in_p+__builtin_ctz(bits));
+    }
+    // Tail is here, not in ve_scan_sse2() - legacy SSE code after 256 bit one costs more than whole short string
+    while(in_p < in_end && ve_clean(*in_p, in_mode)) in_p++;
+    return(in_p);
+}
+#endif // VE_X86
+/* ========================================================================= */
+static ve_scan_f ve_scan_fun(int in_level) {
+
+    if(in_level == V2_SIDX_AUTO) in_level=v2_sidx_level();
+    if(in_level > v2_sidx_level()) in_level=v2_sidx_level(); // CPU does not support asked one
+
+#ifdef VE_X86
+    if(in_level == V2_SIDX_AVX2) return(&ve_scan_avx2);
+    if(in_level == V2_SIDX_SSE2) return(&ve_scan_sse2);
+#endif
+    return(&ve_scan_scalar);
+}
+/* ========================================================================= */
+// One char as u8_escape_wchar() makes it
+static char *ve_wchar(char *out, uint32_t in_ch) {
+    int x=0;
+
+    switch(in_ch) {
+    case '\n': *out++='\\'; *out++='n';  return(out);
+    case '\t': *out++='\\'; *out++='t';  return(out);
+    case '\r': *out++='\\'; *out++='r';  return(out);
+    case '\b': *out++='\\'; *out++='b';  return(out);
+    case '\f': *out++='\\'; *out++='f';  return(out);
+    case '\v': *out++='\\'; *out++='v';  return(out);
+    case '\a': *out++='\\'; *out++='a';  return(out);
+    case '\\': *out++='\\'; *out++='\\'; return(out);
+    }
+
+    if(in_ch < 32 || in_ch == 0x7F) { // "\x%hhX"
+	*out++='\\';
+	*out++='x';
+	if(in_ch >= 16) *out++=ve_hex[in_ch >> 4];
+	*out++=ve_hex[in_ch & 15];
+    } else if(in_ch > 0xFFFF) { // "\U%.8X"
+	*out++='\\';
+	*out++='U';
+	for(x=28; x >= 0; x-=4) *out++=ve_hex[(in_ch >> x) & 15];
+    } else if(in_ch >= 0x80) { // "\u%.4hX"
+	*out++='\\';
+	*out++='u';
+	for(x=12; x >= 0; x-=4) *out++=ve_hex[(in_ch >> x) & 15];
+    } else {
+	*out++=(char)in_ch;
+    }
+    return(out);
+}
+/* ========================================================================= */
+size_t v2_esc_level(int in_level, char *out_str, const char *in_str, size_t in_len, int in_mode) {
+    const unsigned char *p=(const unsigned char *)in_str;
+    const unsigned char *end=p+in_len;
+    const unsigned char *run=NULL;
+    ve_scan_f scan=NULL;
+    char *out=out_str;
+    uint32_t ch=0;
+    int sz=0;
+
+    if(in_mode == V2_ESC_NONE) {
+	memcpy(out_str, in_str, in_len);
+	out_str[in_len]='\0';
+	return(in_len);
+    }
+
+    while(p < end) {
+	if(end-p < 16) { // Block scan does not pay on short rests
+	    run=ve_scan_scalar(p, end, in_mode);
+	} else {
+	    if(!scan) scan=ve_scan_fun(in_level);
+	    run=scan(p, end, in_mode);
+	}
+	if(in_mode != V2_ESC_QUOTES && run < end && run > p && (*run & 0xC0) == 0x80) run--; // Continuation byte - last ASCII one is its lead for u8_nextchar()
+	memcpy(out, p, run-p);
+	out+=run-p;
+	if((p=run) >= end) break;
+
+	if(*p == '"') {
+	    *out++='\\';
+	    *out++='"';
+	    p++;
+	    continue;
+	}
+
+	// As u8_nextchar(): lead byte with all continuation bytes after it
+	ch=0;
+	sz=0;
+	do {
+	    ch <<= 6;
+	    ch += *p++;
+	    sz++;
+	} while(p < end && (*p & 0xC0) == 0x80);
+	if(sz <= 6) ch-=ve_utf8_off[sz-1];
+
+	out=ve_wchar(out, ch);
+    }
+
+    *out='\0';
+    return(out-out_str);
+}
+/* ========================================================================= */
+size_t v2_esc(char *out_str, const char *in_str, size_t in_len, int in_mode) {
+
+    return(v2_esc_level(V2_SIDX_AUTO, out_str, in_str, in_len, in_mode));
+}
+/* ========================================================================= */
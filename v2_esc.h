@@ -0,0 +1,44 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _V2_ESC_H
+#define _V2_ESC_H 1
+
+/*
+ * Json string escaping by 16/32 bytes blocks: clean runs are copied as is, only quotes,
+ * backslashes, control and non-ASCII bytes are handled one by one.
+ * Output is the same as u8_escape(,,,1) and v2_json_escape_quotas() give.
+ */
+
+#include <stdlib.h>
+
+// in_mode is json_box_t no_escape
+#define V2_ESC_UTF8   0 // As u8_escape(,,,1): \" \\ \n \t \r \b \f \v \a, \xX for other controls, \uXXXX, \UXXXXXXXX for non-ASCII
+#define V2_ESC_NONE   1 // Copy
+#define V2_ESC_QUOTES 2 // Quotes only, as v2_json_escape_quotas()
+
+// Output size for in_len bytes of input - worst one is 6 bytes per byte (lone byte 0x80-0xFF as \u00XX)
+#define V2_ESC_SIZE(in_len) ((in_len)*6+1)
+
+// Escapes in_len bytes (no '\0' inside) to out_str[V2_ESC_SIZE(in_len)], returns output length, adds '\0'
+size_t v2_esc(char *out_str, const char *in_str, size_t in_len, int in_mode);
+
+// Same by given stage level of v2_sidx.h (V2_SIDX_AUTO ... V2_SIDX_AVX2) - to compare them
+size_t v2_esc_level(int in_level, char *out_str, const char *in_str, size_t in_len, int in_mode);
+
+#endif // _V2_ESC_H
@@ -20,7 +20,9 @@
 #include <iconv.h>
 #include <stdio.h>
 #include <string.h>
-// #include <errno.h>
+#include <errno.h>
+
+#include "v2_iconv.h"
 
 /* ========================================================= */
 char *v2_iconv(char *fm_locale, char *to_locale, char *in_str) {
@@ -69,8 +71,20 @@ char *v2_iconv(char *fm_locale, char *to_locale, char *in_str) {
 	return(strncpy(o_buf, in_str, o_len));
     }
 
-    if(iconv(i_conv, &i_buf, &i_len, &t_buf, &t_len) == (size_t)-1) {
-	return(strncpy(o_buf, in_str, o_len));
+    while(iconv(i_conv, &i_buf, &i_len, &t_buf, &t_len) == (size_t)-1) {
+	if(errno != E2BIG) return(strncpy(o_buf, in_str, o_len));
+
+	// Output is full - grow it, converted part stays
+	t_len=t_buf-o_buf;
+	o_len*=2;
+	if(!(t_buf=(char*)realloc(o_buf, o_len+1))) {
+	    iconv_close(i_conv);
+	    o_buf[t_len]='\0';
+	    return(o_buf); // Only what fit
+	}
+	o_buf=t_buf;
+	t_buf=o_buf+t_len;
+	t_len=o_len-t_len;
     }
 
     iconv_close(i_conv);
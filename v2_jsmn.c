@@ -18,15 +18,22 @@
 
 // ERROR_CODE 173XX : 17300 - 17349
 
+#include <limits.h>
+#include <pthread.h>
+
 #include "v2_jsmn.h"
+#include "v2_num.h"
 #include "v2_iconv.h"
 #include "utf8.h"
 
-v2_jsmn_t v2_jsmn; // Read Write buffer
 
-/* ================== Proto ================================================ */
-int vj_make_array();
-int vj_make_object();
+/* ================== Types ================================================ */
+// Open container while tokens are walked
+typedef struct {
+    int left;     // Elements not built yet
+    char is_obj;  // Object - element starts by member name
+    char is_node; // Has node to end (root object has not)
+} vj_level_t;
 
 /* ========================================================================= */
 int v2_jsmn_init(v2_jsmn_t *in_jsmn) {
@@ -45,78 +52,214 @@ int v2_jsmn_init(v2_jsmn_t *in_jsmn) {
     in_jsmn->tcnt = 0;
     in_jsmn->tcur = 0;
 
+    v2_tape_free(&in_jsmn->tape);
+
     in_jsmn->json=NULL;
+    in_jsmn->none=0;
+    in_jsmn->root=JS_NONE;
+
+    if(in_jsmn->fstk) { // Chunked input state
+	free(in_jsmn->fstk);
+	in_jsmn->fstk=NULL;
+    }
+    in_jsmn->fmax  = 0;
+    in_jsmn->fname = NULL;
+    in_jsmn->fdep  = 0;
+    in_jsmn->foff  = 0;
+    in_jsmn->fstat = 0;
+    in_jsmn->frc   = 0;
+
+    return(0);
+}
+/* ========================================================================= */
+// Set size of tokens array, keep tokens already parsed
+static int vj_tokens_grow(v2_jsmn_t *in_jsmn, int in_max) {
+    jsmntok_t *tok_tmp=NULL;
+
+    if(!(tok_tmp=(jsmntok_t *)realloc(in_jsmn->tokens, in_max*sizeof(jsmntok_t)))) return(17316);
+
+    in_jsmn->tokens=tok_tmp;
+    in_jsmn->tmax=in_max;
 
     return(0);
 }
 /* ========================================================================= */
-char *vj_get_string(v2_jsmn_t *in_jsmn) {
-    static char strtmp[MAX_STRING_LEN];
-    static char strtm1[MAX_STRING_LEN];
+// u8_unescape() by text span - json text has quota after the span, so escapes do not go out of it
+// Result is never longer than in_len
+static size_t vj_unescape(char *out_str, const char *in_str, size_t in_len) {
+    const char *end=in_str+in_len;
+    u_int32_t ch;
+    size_t c=0;
+    int amt=0;
+
+    while(in_str < end && *in_str) {
+	if(*in_str == '\\') {
+	    in_str++;
+	    amt=u8_read_escape_sequence((char *)in_str, &ch);
+	} else {
+	    ch=(u_int32_t)*in_str & 0x000000ff;
+	    amt=1;
+	}
+	in_str+=amt;
+	c+=u8_wc_toutf8(out_str+c, ch);
+    }
+    out_str[c]='\0';
+
+    return(c);
+}
+/* ========================================================================= */
+// Unescaped copy of text span to in_buf[in_siz] if it fits, else to allocated one - free it if it is not in_buf
+// NULL - no memory
+static char *vj_unescape_tmp(char *in_buf, size_t in_siz, const char *in_str, size_t in_len, size_t *p_len) {
+    char *out=in_buf;
+
+    if(in_len >= in_siz && !(out=(char *)malloc(in_len+1))) return(NULL);
+
+    *p_len=vj_unescape(out, in_str, in_len);
+    return(out);
+}
+/* ========================================================================= */
+// Unescaped (and delocalized) text of in_len bytes at in_start to out_str[out_size], text itself has no limit
+static char *vj_get_text(v2_jsmn_t *in_jsmn, char *out_str, size_t out_size, size_t in_start, size_t in_len) {
+    char buf[256];
+    char *tmp=NULL;
     char *out=NULL;
-    int len=in_jsmn->tokens[in_jsmn->tcur].end-in_jsmn->tokens[in_jsmn->tcur].start+1; // add '\n'
-    //int x=0;
-    //int y=0;
+    size_t len=0;
 
-    if(len > MAX_STRING_LEN) len = MAX_STRING_LEN; // Trunkate long string
+    if(!(tmp=vj_unescape_tmp(buf, sizeof(buf), in_jsmn->b->pos+in_start, in_len, &len))) return(NULL);
 
-    snprintf(strtmp, len, "%s", in_jsmn->b->pos+in_jsmn->tokens[in_jsmn->tcur].start);
+    if(in_jsmn->locale && (out=v2_iconv("UTF-8", in_jsmn->locale, tmp))) {
+	snprintf(out_str, out_size, "%s", out);
+	v2_freestr(&out);
+    } else {
+	snprintf(out_str, out_size, "%s", tmp);
+    }
 
-    //for(y=in_jsmn->tokens[in_jsmn->tcur].start; y<in_jsmn->tokens[in_jsmn->tcur].end && x<MAX_STRING_LEN; y++, x++) {
-    //    strtmp[x]=in_jsmn->b->pos[y];
-    //}
-    //strtmp[x]='\0';
+    if(tmp != buf) free(tmp);
+    return(out_str);
+}
+/* ========================================================================= */
+// String value by text span: one copy (or unescape) right to box memory, any length
+static int vj_make_string(v2_jsmn_t *in_jsmn, char *in_name, size_t in_start, size_t in_len, int is_esc) {
+    const char *str=in_jsmn->b->pos+in_start;
+    char *val=NULL;
+    char *out=NULL;
 
-    u8_unescape(strtm1, MAX_STRING_LEN, strtmp);
+    if(!(val=v2_json_str_new(in_jsmn->box, in_name, in_len))) return(17318);
+
+    if(is_esc) {
+	vj_unescape(val, str, in_len);
+    } else {
+	memcpy(val, str, in_len);
+	val[in_len]='\0';
+    }
 
     if(in_jsmn->locale) {
-	if((out=v2_iconv("UTF-8", in_jsmn->locale, strtm1))) {
-	    snprintf(strtm1, MAX_STRING_LEN, "%s", out);
+	if((out=v2_iconv("UTF-8", in_jsmn->locale, val))) {
+	    in_jsmn->box->tek->str=v2_json_strdup(in_jsmn->box, out);
 	    v2_freestr(&out);
 	}
     }
 
-    return(strtm1);
+    return(0);
 }
 /* ========================================================================= */
-int vj_make_value(v2_jsmn_t *in_jsmn, char *in_name) {
-    char name[MAX_STRING_LEN];
-    char *in_val=NULL;
-    static int none=0;
-
-    if(!in_jsmn) return(17202);
+// Value name: object member name itself or "_array_NNNN" in out_name for array members and root value
+static char *vj_name(char *out_name, char *in_name, int *p_none) {
 
     if(!in_name || !in_name[0]) {
-	sprintf(name, "_array_%04d", ++none);
+	sprintf(out_name, "_array_%04d", ++(*p_none));
+	return(out_name);
+    }
+    return(in_name);
+}
+/* ========================================================================= */
+// Member name by text span, interned in box: right from text if it needs no unescape, else unescaped (and delocalized) copy
+// Any length, NULL - no memory
+static char *vj_get_key(v2_jsmn_t *in_jsmn, size_t in_start, size_t in_len, int is_esc) {
+    const char *str=in_jsmn->b->pos+in_start;
+    char buf[256]; // Most names fit
+    char *tmp=NULL;
+    char *out=NULL;
+    char *key=NULL;
+    size_t len=0;
+
+    if(!is_esc && !in_jsmn->locale) return(v2_json_key(in_jsmn->box, str, in_len));
+
+    if(is_esc) {
+	if(!(tmp=vj_unescape_tmp(buf, sizeof(buf), str, in_len, &len))) return(NULL);
+    } else {
+	if(in_len >= sizeof(buf) && !(tmp=(char *)malloc(in_len+1))) return(NULL);
+	if(!tmp) tmp=buf;
+	memcpy(tmp, str, in_len);
+	tmp[len=in_len]='\0';
+    }
+
+    if(in_jsmn->locale && (out=v2_iconv("UTF-8", in_jsmn->locale, tmp))) {
+	key=v2_json_key(in_jsmn->box, out, strlen(out));
+	v2_freestr(&out);
     } else {
-	sprintf(name, "%s", in_name);
-    }
-
-    if(in_jsmn->tokens[in_jsmn->tcur].type==JSMN_OBJECT) {
-	if(in_jsmn->tcur) v2_json_obj(in_jsmn->box, name); // Add object name, if it is not root obj
-	vj_make_object(in_jsmn);
-	if(in_jsmn->tcur) v2_json_end(in_jsmn->box);
-    } else if(in_jsmn->tokens[in_jsmn->tcur].type==JSMN_ARRAY) {
-	v2_json_arr(in_jsmn->box, name);
-	vj_make_array(in_jsmn);
-	v2_json_end(in_jsmn->box);
-    } else if(in_jsmn->tokens[in_jsmn->tcur].type==JSMN_STRING) {
-	v2_json_str(in_jsmn->box, name, vj_get_string(in_jsmn));
+	key=v2_json_key(in_jsmn->box, tmp, len);
+    }
+
+    if(tmp != buf) free(tmp);
+    return(key);
+}
+/* ========================================================================= */
+// Number by primitive text in place: JS_LONG or JS_DOUBLE, both values are set
+static json_field vj_num(const char *in_val, size_t in_len, long long *p_lnum, double *p_dnum) {
+
+    switch(v2_num_parse(in_val, in_len, p_lnum, p_dnum)) {
+    case V2_NUM_LONG:
+	*p_dnum=*p_lnum;
+	return(JS_LONG);
+    case V2_NUM_DOUBLE:
+	*p_lnum=(long long)*p_dnum;
+	return(JS_DOUBLE);
+    }
+
+    // Not json number - old way, text ends by delimiter anyway
+    if(memchr(in_val, '.', in_len)) {
+	*p_dnum=atof(in_val);
+	*p_lnum=(long long)*p_dnum;
+	return(JS_DOUBLE);
+    }
+    *p_lnum=atoll(in_val);
+    *p_dnum=*p_lnum;
+    return(JS_LONG);
+}
+/* ========================================================================= */
+// Primitive by its text: null, true, false or number
+static int vj_make_primitive(v2_jsmn_t *in_jsmn, char *in_name, const char *in_val, size_t in_len) {
+    long long lnum=0;
+    double dnum=0;
+
+    if(!in_len) {
+	v2_json_null(in_jsmn->box, in_name);
+    } else if(in_val[0] == 'n') {
+	v2_json_null(in_jsmn->box, in_name);
+    } else if(in_val[0] == 'f') {
+	v2_json_bool(in_jsmn->box, in_name, 0);
+    } else if(in_val[0] == 't') {
+	v2_json_bool(in_jsmn->box, in_name, 1);
+    } else if(vj_num(in_val, in_len, &lnum, &dnum) == JS_DOUBLE) {
+	v2_json_double(in_jsmn->box, in_name, dnum);
+    } else {
+	v2_json_lint(in_jsmn->box, in_name, lnum);
+    }
+
+    return(0);
+}
+/* ========================================================================= */
+// String or primitive
+static int vj_make_scalar(v2_jsmn_t *in_jsmn, char *in_name) {
+
+    jsmntok_t *tok=&in_jsmn->tokens[in_jsmn->tcur];
+
+    if(tok->type==JSMN_STRING) {
+	return(vj_make_string(in_jsmn, in_name, tok->start, tok->end-tok->start, memchr(in_jsmn->b->pos+tok->start, '\\', tok->end-tok->start) != NULL));
     } else if(in_jsmn->tokens[in_jsmn->tcur].type==JSMN_PRIMITIVE) { // What to do?
-        in_val=vj_get_string(in_jsmn);
-	if(!in_val) {
-	    v2_json_null(in_jsmn->box, name);
-	} else if(in_val[0] == 'n') {
-	    v2_json_null(in_jsmn->box, name);
-	} else if(in_val[0] == 'f') {
-	    v2_json_bool(in_jsmn->box, name, 0);
-	} else if(in_val[0] == 't') {
-	    v2_json_bool(in_jsmn->box, name, 1);
-	} else if(strchr(in_val, '.')) {
-	    v2_json_double(in_jsmn->box, name, atof(in_val));
-	} else {
-	    v2_json_lint(in_jsmn->box, name, atoll(in_val));
-	}
+	vj_make_primitive(in_jsmn, in_name, in_jsmn->b->pos+in_jsmn->tokens[in_jsmn->tcur].start, in_jsmn->tokens[in_jsmn->tcur].end-in_jsmn->tokens[in_jsmn->tcur].start);
     } else if(in_jsmn->tokens[in_jsmn->tcur].type==JSMN_UNDEFINED) { // What to do?
 	// Undefined primitive ???
     }
@@ -124,48 +267,212 @@ int vj_make_value(v2_jsmn_t *in_jsmn, char *in_name) {
     return(0);
 }
 /* ========================================================================= */
-int vj_make_array(v2_jsmn_t *in_jsmn) {
-    int nums=in_jsmn->tokens[in_jsmn->tcur].size;
+// Build tree by tokens from tcur - open containers are kept on heap stack, so any depth is fine
+int vj_make_value(v2_jsmn_t *in_jsmn, char *in_name) {
+    char strtmp[MAX_STRING_LEN];
+    char *name=in_name;
+    jsmntok_t *tok=NULL;
+    vj_level_t *stk=NULL;
+    vj_level_t *stk_tmp=NULL;
+    vj_level_t *lev=NULL;
+    size_t dep=0;
+    size_t max=0;
     int rc=0;
-    int x=0;
 
-    for(x=0; x<nums && !rc; x++) {
-	in_jsmn->tcur++;
-	rc=vj_make_value(in_jsmn, NULL);
+    if(!in_jsmn) return(17202);
+
+    for(;;) {
+	tok=&in_jsmn->tokens[in_jsmn->tcur];
+	name=vj_name(strtmp, name, &in_jsmn->none);
+
+	if(tok->type==JSMN_OBJECT || tok->type==JSMN_ARRAY) {
+	    if(dep >= max) {
+		if(!(stk_tmp=(vj_level_t *)realloc(stk, (max ? max*2 : 64)*sizeof(vj_level_t)))) { rc=17328; break; }
+		stk=stk_tmp;
+		max=(max ? max*2 : 64);
+	    }
+	    lev=&stk[dep++];
+	    lev->left=tok->size;
+	    lev->is_obj=(tok->type==JSMN_OBJECT);
+	    lev->is_node=(!lev->is_obj || in_jsmn->tcur); // Root object has no node
+
+	    if(!lev->is_obj)    v2_json_arr(in_jsmn->box, name);
+	    else if(lev->is_node) v2_json_obj(in_jsmn->box, name); // Add object name, if it is not root obj
+	} else if((rc=vj_make_scalar(in_jsmn, name))) {
+	    break;
+	}
+
+	// Next element, finished containers are closed
+	name=NULL;
+	while(dep) {
+	    lev=&stk[dep-1];
+	    if(!lev->left) {
+		dep--;
+		if(lev->is_node) v2_json_end(in_jsmn->box);
+		continue;
+	    }
+	    lev->left--;
+	    in_jsmn->tcur++;
+	    if(!lev->is_obj) break;
+
+	    tok=&in_jsmn->tokens[in_jsmn->tcur]; // Member name first
+	    if(tok->type != JSMN_STRING) { // This is not name - rest of the object is skipped
+		dep--;
+		v2_json_end(in_jsmn->box);
+		continue;
+	    }
+	    if(!(name=vj_get_key(in_jsmn, tok->start, tok->end-tok->start, memchr(in_jsmn->b->pos+tok->start, '\\', tok->end-tok->start) != NULL))) {
+		rc=17324;
+		dep=0;
+	    }
+	    in_jsmn->tcur++;
+	    break;
+	}
+	if(!dep) break;
     }
+
+    free(stk);
     return(rc);
 }
 /* ========================================================================= */
-int vj_make_object(v2_jsmn_t *in_jsmn) {
-    char str_name[MAX_STRING_LEN];
-    int nums=in_jsmn->tokens[in_jsmn->tcur].size;
-    int x=0;
-    //int is_name=0;
+// Build tree by tape words in_from..in_to-1 - words go in text order, so no recursion is needed
+// "_array_NNNN" names are counted by *p_none, is_count - only count them, nothing is built
+static int vj_make_tape_part(v2_jsmn_t *in_jsmn, size_t in_from, size_t in_to, int *p_none, int is_count) {
+    char strtmp[MAX_STRING_LEN];
+    char *key=NULL;
+    char *name=NULL;
+    v2_tape_t *tape=&in_jsmn->tape;
+    const char *js=in_jsmn->b->pos;
+    size_t len=in_jsmn->b->yet;
+    size_t x=0;
+    uint64_t w=0;
+    int is_name=0;
     int rc=0;
 
-    for(x=0; x<nums && !rc; x++) {
-	in_jsmn->tcur++;
+    for(x=in_from; x<in_to; x++) {
+	w=tape->w[x];
+
+	switch(V2_TAPE_TYPE(w)) {
+	case 'k':
+	    if(is_count && !V2_TAPE_ESC(w) && !in_jsmn->locale) key=(char *)(v2_tape_len(js, len, w)?js+V2_TAPE_VAL(w):""); // Only empty or not
+	    else if(!(key=vj_get_key(in_jsmn, V2_TAPE_VAL(w), v2_tape_len(js, len, w), V2_TAPE_ESC(w)))) return(17324);
+	    is_name=1;
+	    continue;
+	case '{':
+	case '[':
+	    name=vj_name(strtmp, is_name?key:NULL, p_none);
+	    if(is_count)                break;
+	    if(V2_TAPE_TYPE(w) == '[')  v2_json_arr(in_jsmn->box, name);
+	    else if(x)                  v2_json_obj(in_jsmn->box, name); // Add object name, if it is not root obj
+	    break;
+	case '}':
+	case ']':
+	    if(is_count) break;
+	    if(V2_TAPE_TYPE(w) == ']' || V2_TAPE_VAL(w)) v2_json_end(in_jsmn->box);
+	    break;
+	case '"':
+	    name=vj_name(strtmp, is_name?key:NULL, p_none);
+	    if(is_count) break;
+	    if((rc=vj_make_string(in_jsmn, name, V2_TAPE_VAL(w), v2_tape_len(js, len, w), V2_TAPE_ESC(w)))) return(rc);
+	    break;
+	case 'p':
+	    name=vj_name(strtmp, is_name?key:NULL, p_none);
+	    if(is_count) break;
+	    vj_make_primitive(in_jsmn, name, js+V2_TAPE_VAL(w), v2_tape_len(js, len, w));
+	    break;
+	}
+	is_name=0;
+    }
+
+    return(0);
+}
+/* ========================================================================= */
+// Root array part, built by own thread into own box
+typedef struct {
+    v2_jsmn_t jsmn; // Copy of parser with own box
+    json_box_t box;
+    size_t from;    // First tape word
+    size_t to;      // After last tape word
+    int none;       // Names counter
+    int rc;
+} vj_part_t;
+
+static void *vj_part_run(void *in_part) {
+    vj_part_t *part=(vj_part_t *)in_part;
+
+    part->rc=vj_make_tape_part(&part->jsmn, part->from, part->to, &part->none, 0);
+    return(NULL);
+}
+/* ========================================================================= */
+// Root array elements are split to in_jsmn->threads parts by tape size, parts are joined in order
+static int vj_make_tape_threads(v2_jsmn_t *in_jsmn) {
+    v2_tape_t *tape=&in_jsmn->tape;
+    pthread_t thr[V2_JSMN_THREADS_MAX];
+    vj_part_t *part=NULL;
+    int is_thr[V2_JSMN_THREADS_MAX];
+    size_t all=tape->cnt-1; // Last word - root ']'
+    size_t step=0;
+    size_t x=1;
+    int n=in_jsmn->threads;
+    int cnt=0;
+    int i=0;
+    int rc=0;
+
+    if(n > V2_JSMN_THREADS_MAX) n=V2_JSMN_THREADS_MAX;
+    if(!(part=(vj_part_t *)calloc(n, sizeof(vj_part_t)))) return(17330);
+
+    if((rc=vj_make_tape_part(in_jsmn, 0, 1, &in_jsmn->none, 0))) goto out; // Root '['
+
+    step=(all-1)/n+1;
+    for(cnt=0; x < all && cnt < n; cnt++) { // Cut by element ends
+	part[cnt].from=x;
+	while(x < all && x-part[cnt].from < step) {
+	    if(V2_TAPE_TYPE(tape->w[x]) == '{' || V2_TAPE_TYPE(tape->w[x]) == '[') x=V2_TAPE_VAL(tape->w[x]);
+	    x++;
+	}
+	if(cnt == n-1) x=all;
+	part[cnt].to=x;
+
+	part[cnt].none=in_jsmn->none; // Part starts where serial build would be
+	if((rc=vj_make_tape_part(in_jsmn, part[cnt].from, part[cnt].to, &in_jsmn->none, 1))) goto out;
+
+	part[cnt].jsmn=*in_jsmn;
+	part[cnt].jsmn.box=&part[cnt].box;
+	if((rc=v2_json_sub(in_jsmn->box, &part[cnt].box))) goto out;
+    }
 
-	// 1. Name
-	//if((is_name=1-is_name)) {
-	    if(in_jsmn->tokens[in_jsmn->tcur].type != JSMN_STRING) return(17340); // This is not name
-	    sprintf(str_name, "%s", vj_get_string(in_jsmn));
-	//    continue;
-	//}
-	// Value
+    for(i=1; i<cnt; i++) is_thr[i]=!pthread_create(&thr[i], NULL, vj_part_run, &part[i]);
+    vj_part_run(&part[0]);
+    for(i=1; i<cnt; i++) {
+	if(is_thr[i]) pthread_join(thr[i], NULL);
+	else          vj_part_run(&part[i]); // No thread - do it here
+    }
 
-        in_jsmn->tcur++;
-	rc=vj_make_value(in_jsmn, str_name);
+    for(i=0; i<cnt; i++) {
+	if(!rc) rc=part[i].rc;
+	if(!rc) rc=v2_json_add_box(in_jsmn->box, &part[i].box);
     }
 
+    if(!rc) rc=vj_make_tape_part(in_jsmn, all, tape->cnt, &in_jsmn->none, 0); // Root ']'
+
+ out:
+    for(i=0; i<n; i++) v2_json_free_sub(&part[i].box); // Not joined ones
+    free(part);
     return(rc);
 }
 /* ========================================================================= */
+static int vj_make_tape(v2_jsmn_t *in_jsmn) {
+
+    if(in_jsmn->threads > 1 && in_jsmn->tape.cnt >= V2_JSMN_THREADS_MIN && V2_TAPE_TYPE(in_jsmn->tape.w[0]) == '[') {
+	return(vj_make_tape_threads(in_jsmn));
+    }
+
+    return(vj_make_tape_part(in_jsmn, 0, in_jsmn->tape.cnt, &in_jsmn->none, 0));
+}
+/* ========================================================================= */
 // Don't use it separately
 static int v2_jsmn_parse_any(v2_jsmn_t *in_jsmn) {
-    int t_max=0;
     int rc=0;
-    int x=0;
 
     if(!in_jsmn) return(17300);
     if((rc=v2_wrbuf_ok(in_jsmn->b))) return(rc);
@@ -187,27 +494,52 @@ static int v2_jsmn_parse_any(v2_jsmn_t *in_jsmn) {
     if(in_jsmn->b->pos[in_jsmn->b->yet] != '\0')  return(17313); // Non zero end of buffer - required
     // -^^^- not needs -^^^-
 
-    // Count toekns value
-    in_jsmn->tmax=0;
-    for(x=0; x<in_jsmn->b->yet; x++) {
-	if(in_jsmn->b->pos[x] == ':') in_jsmn->tmax++; // Tokens
-	if(in_jsmn->b->pos[x] == ',') in_jsmn->tmax++; // Array members
-    }
+    in_jsmn->root=(in_jsmn->b->pos[0] == '[') ? JS_ARRAY : JS_OBJECT; // Root array has node, root object has not
 
-    if(in_jsmn->tmax == 0)      in_jsmn->tmax=t_max;
-    if(in_jsmn->tmax == 0)      return(17314); // Not found any json separator... Maybe wrong for 1-element array
-    if(in_jsmn->tmax > 5000000) return(17315); // Look so hight size... What to do?
+    if(in_jsmn->backend == V2_JSMN_BACK_TAPE || in_jsmn->lazy) {
+	rc=v2_sidx_tape(V2_SIDX_AUTO, in_jsmn->b->pos, in_jsmn->b->yet, &in_jsmn->tape);
+	if(rc==JSMN_ERROR_NOMEM) return(17320);
+	if(!rc) {
+	    if(!in_jsmn->lines && in_jsmn->tape.cnt < in_jsmn->tape.max) { // Shrink to fit
+		uint64_t *w_tmp=NULL;
+		if((w_tmp=(uint64_t *)realloc(in_jsmn->tape.w, in_jsmn->tape.cnt*sizeof(uint64_t)))) {
+		    in_jsmn->tape.w=w_tmp;
+		    in_jsmn->tape.max=in_jsmn->tape.cnt;
+		}
+	    }
+	    if(in_jsmn->lazy) return(0); // Values are read by v2_jsmn_get*()
 
-    in_jsmn->tmax*=2; // Make 2 times more, each ':' gives maximal 2 tokens
-    in_jsmn->tmax+=1; // One extra token - ROOT element
+	    if((rc=v2_json_new(&in_jsmn->box))) return(rc);
+	    if((rc=vj_make_tape(in_jsmn))) return(rc);
+	    in_jsmn->json=in_jsmn->box->lst; // Copy pointer to main value
+	    return(0);
+	}
+	rc=0; // Broken json - let jsmn_parse() decide
+    }
+
+    if(in_jsmn->b->yet > INT_MAX) return(17317); // jsmntok_t keeps int offsets
 
     if((rc=v2_json_new(&in_jsmn->box))) return(rc);
 
-    if(!(in_jsmn->tokens=(jsmntok_t *)calloc(in_jsmn->tmax+1, sizeof(jsmntok_t)))) return(17316);
+    // First guess by buffer size, jsmn_parse() resumes from the same place after JSMN_ERROR_NOMEM
+    if(in_jsmn->tmax < (int)(in_jsmn->b->yet/V2_JSMN_TOK_BYTES+16)) {
+	if((rc=vj_tokens_grow(in_jsmn, in_jsmn->b->yet/V2_JSMN_TOK_BYTES+16))) return(rc);
+    }
+
+    if(in_jsmn->backend == V2_JSMN_BACK_SIDX) {
+	in_jsmn->tcnt=v2_sidx_parse(V2_SIDX_AUTO, in_jsmn->b->pos, in_jsmn->b->yet, &in_jsmn->tokens, &in_jsmn->tmax);
+	if(in_jsmn->tcnt==JSMN_ERROR_NOMEM) return(17320);
+    }
+
+    if((in_jsmn->backend != V2_JSMN_BACK_SIDX) || (in_jsmn->tcnt == V2_SIDX_SLOW)) {
+	while((in_jsmn->tcnt=jsmn_parse(&in_jsmn->parser, in_jsmn->b->pos, in_jsmn->b->yet, in_jsmn->tokens, in_jsmn->tmax)) == JSMN_ERROR_NOMEM) {
+	    if(in_jsmn->tmax > INT_MAX/2) return(17320); // No mem - int token index overflow
+	    if((rc=vj_tokens_grow(in_jsmn, in_jsmn->tmax*2))) return(rc);
+	}
+    }
 
-    in_jsmn->tcnt=jsmn_parse(&in_jsmn->parser, in_jsmn->b->pos, in_jsmn->b->yet, in_jsmn->tokens, in_jsmn->tmax);
+    if(!in_jsmn->lines && in_jsmn->tcnt > 0 && in_jsmn->tcnt < in_jsmn->tmax) vj_tokens_grow(in_jsmn, in_jsmn->tcnt); // Shrink to fit, keep old array on fail
 
-    if(in_jsmn->tcnt==JSMN_ERROR_NOMEM) rc=17320; // No mem
     if(in_jsmn->tcnt==JSMN_ERROR_INVAL) rc=17321; // Wrong values - invalid chars into strings
     if(in_jsmn->tcnt==JSMN_ERROR_PART)  rc=17322; // Unexpected and of the json
 
@@ -227,10 +559,15 @@ int v2_jsmn_parse_file(v2_jsmn_t *in_jsmn, char *in_file) {
     int rc=0;
     int rc1=0;
 
+    if(in_file && !strcmp(in_file, "-") && !in_jsmn->lazy) return(v2_jsmn_feed_file(in_jsmn, in_file)); // Pipe - don't wait for all data
+
     if((rc=v2_jsmn_init(in_jsmn))) return(rc);
-    if(!in_jsmn->b) v2_wrbuf_new(&in_jsmn->b); // If needs - create buffer
+    v2_wrbuf_new(&in_jsmn->b); // Create or clean buffer
     if((rc=v2_wrbuf_file_read(in_jsmn->b, in_file))) return(rc);
     rc=v2_jsmn_parse_any(in_jsmn);
+    if(!rc && in_jsmn->lazy && in_jsmn->tape.cnt) return(0); // Tape points to the text - keep it
+
+    v2_tape_free(&in_jsmn->tape);
     if((rc1=v2_wrbuf_reset(in_jsmn->b))) return(rc1); // Clear previouse value in any case
     
     return(rc);
@@ -246,6 +583,574 @@ int v2_jsmn_parse(v2_jsmn_t *in_jsmn) {
     return(0);
 }
 /* ========================================================================= */
+// Chunked input - tree is built by tokens as they come, not by recursion over all of them
+static int vj_feed_push(v2_jsmn_t *in_jsmn, int in_tok) {
+    int *stk_tmp=NULL;
+
+    if(in_jsmn->fdep >= in_jsmn->fmax) {
+	if(!(stk_tmp=(int *)realloc(in_jsmn->fstk, (in_jsmn->fmax+64)*sizeof(int)))) return(17323);
+	in_jsmn->fstk=stk_tmp;
+	in_jsmn->fmax+=64;
+    }
+    in_jsmn->fstk[in_jsmn->fdep++]=in_tok;
+
+    return(0);
+}
+/* ========================================================================= */
+// Close containers which closing bracket is before in_pos
+static int vj_feed_close(v2_jsmn_t *in_jsmn, int in_pos) {
+    jsmntok_t *tok=NULL;
+
+    while(in_jsmn->fdep) {
+	tok=&in_jsmn->tokens[in_jsmn->fstk[in_jsmn->fdep-1]];
+	if(tok->end == -1 || tok->end > in_pos) break;
+
+	if(--in_jsmn->fdep) {
+	    v2_json_end(in_jsmn->box);
+	} else { // Root value
+	    if(tok->type == JSMN_ARRAY) v2_json_end(in_jsmn->box);
+	    if(in_jsmn->foff+tok->end == 2) in_jsmn->fstat=3; // "[]" or "{}" - nothing to build
+	    else                            in_jsmn->fstat=2;
+	}
+    }
+    return(0);
+}
+/* ========================================================================= */
+// Build tree by new tokens: from tcur up to parser.toknext
+static int vj_feed_build(v2_jsmn_t *in_jsmn) {
+    char name[MAX_STRING_LEN]; // "_array_NNNN"
+    char *id=NULL;
+    jsmntok_t *tok=NULL;
+    int rc=0;
+
+    for(; in_jsmn->tcur < (int)in_jsmn->parser.toknext; in_jsmn->tcur++) {
+	tok=&in_jsmn->tokens[in_jsmn->tcur];
+
+	vj_feed_close(in_jsmn, tok->start);
+	if(in_jsmn->fstat > 1) continue; // Text after root value is not used
+
+	if(!in_jsmn->fdep) { // Root: '{' or '[' - checked by first byte
+	    vj_name(name, NULL, &in_jsmn->none);
+	    if(tok->type == JSMN_ARRAY) v2_json_arr(in_jsmn->box, name);
+	    in_jsmn->fstat=1;
+	    if((rc=vj_feed_push(in_jsmn, in_jsmn->tcur))) return(rc);
+	    continue;
+	}
+
+	if(in_jsmn->tokens[in_jsmn->fstk[in_jsmn->fdep-1]].type == JSMN_OBJECT && !in_jsmn->fname) { // Name
+	    if(tok->type != JSMN_STRING) return(17340); // This is not name
+	    if(!(in_jsmn->fname=vj_get_key(in_jsmn, tok->start, tok->end-tok->start, memchr(in_jsmn->b->pos+tok->start, '\\', tok->end-tok->start) != NULL))) return(17324);
+	    continue;
+	}
+
+	id=vj_name(name, in_jsmn->fname, &in_jsmn->none);
+
+	if(tok->type == JSMN_OBJECT) {
+	    v2_json_obj(in_jsmn->box, id);
+	    rc=vj_feed_push(in_jsmn, in_jsmn->tcur);
+	} else if(tok->type == JSMN_ARRAY) {
+	    v2_json_arr(in_jsmn->box, id);
+	    rc=vj_feed_push(in_jsmn, in_jsmn->tcur);
+	} else {
+	    vj_make_scalar(in_jsmn, id);
+	}
+	in_jsmn->fname=NULL;
+	if(rc) return(rc);
+    }
+
+    vj_feed_close(in_jsmn, INT_MAX);
+
+    return(0);
+}
+/* ========================================================================= */
+// Keep only tokens jsmn_parse() looks back for, drop text already built
+static int vj_feed_compact(v2_jsmn_t *in_jsmn) {
+    jsmntok_t *tok=NULL;
+    int last=in_jsmn->parser.toknext-1;
+    int sup=in_jsmn->parser.toksuper;
+    int x=0;
+    int y=0;
+    int d=0;
+
+    for(x=0; x<=last; x++) {
+	tok=&in_jsmn->tokens[x];
+	if(!(tok->end == -1 && tok->start != -1) && x != sup && x != last) continue;
+
+	// Open container, member name waiting for ':' or value, last token for ':'
+	while(d < in_jsmn->fdep && in_jsmn->fstk[d] < x) d++;
+	if(d < in_jsmn->fdep && in_jsmn->fstk[d] == x) in_jsmn->fstk[d]=y;
+	if(x == sup) in_jsmn->parser.toksuper=y;
+
+	in_jsmn->tokens[y]=*tok;
+	if(in_jsmn->tokens[y].end == -1) in_jsmn->tokens[y].start=0; // Text is dropped below
+	else                             in_jsmn->tokens[y].start=in_jsmn->tokens[y].end=0;
+	y++;
+    }
+
+    in_jsmn->parser.toknext=y;
+    in_jsmn->tcur=y;
+
+    in_jsmn->foff+=in_jsmn->parser.pos;
+    v2_wrbuf_drop(in_jsmn->b, in_jsmn->parser.pos);
+    in_jsmn->parser.pos=0;
+
+    return(0);
+}
+/* ========================================================================= */
+// Tokenize in_len bytes of b and build what is ready
+static int vj_feed_parse(v2_jsmn_t *in_jsmn, size_t in_len) {
+    int rc=0;
+
+    while((in_jsmn->tcnt=jsmn_parse(&in_jsmn->parser, in_jsmn->b->buf, in_len, in_jsmn->tokens, in_jsmn->tmax)) == JSMN_ERROR_NOMEM) {
+	if(in_jsmn->tmax > INT_MAX/2) return(17320); // No mem - int token index overflow
+	if((rc=vj_tokens_grow(in_jsmn, in_jsmn->tmax*2))) return(rc);
+    }
+    if(in_jsmn->tcnt==JSMN_ERROR_INVAL) return(17321); // Wrong values - invalid chars into strings
+
+    if((rc=vj_feed_build(in_jsmn))) return(rc);
+
+    return(vj_feed_compact(in_jsmn));
+}
+/* ========================================================================= */
+int v2_jsmn_feed(v2_jsmn_t *in_jsmn, const char *in_data, size_t in_len) {
+    size_t len=0;
+    char c=0;
+
+    if(!in_jsmn) return(17300);
+    if(in_jsmn->frc) return(in_jsmn->frc);
+    if(!in_data || !in_len) return(0);
+
+    if(!in_jsmn->fstat) { // First chunk
+	if((in_jsmn->frc=v2_jsmn_init(in_jsmn))) return(in_jsmn->frc);
+	if((in_jsmn->frc=v2_wrbuf_new(&in_jsmn->b))) return(in_jsmn->frc);
+	if(in_data[0] != '{' && in_data[0] != '[') {
+	    v2_add_debug(1, "This is not json: %.*s", (int)(in_len<80?in_len:80), in_data);
+	    return(in_jsmn->frc=V2_NO_JSMN);
+	}
+	in_jsmn->root=(in_data[0] == '[') ? JS_ARRAY : JS_OBJECT;
+	if((in_jsmn->frc=v2_json_new(&in_jsmn->box))) return(in_jsmn->frc);
+	if((in_jsmn->frc=vj_tokens_grow(in_jsmn, 256))) return(in_jsmn->frc);
+	in_jsmn->fstat=1;
+    }
+
+    if(v2_wrbuf_write(in_jsmn->b, (char *)in_data, 1, in_len) != in_len) return(in_jsmn->frc=17325);
+
+    // Non strict jsmn takes primitive at the end of text as complete one - leave it for next chunk
+    for(len=in_jsmn->b->cnt; len > in_jsmn->parser.pos; len--) {
+	c=in_jsmn->b->buf[len-1];
+	if(strchr("{}[],:\" \t\r\n", c)) break;
+    }
+
+    return(in_jsmn->frc=vj_feed_parse(in_jsmn, len));
+}
+/* ========================================================================= */
+int v2_jsmn_finish(v2_jsmn_t *in_jsmn) {
+    int rc=0;
+
+    if(!in_jsmn) return(17300);
+
+    if(in_jsmn->frc) rc=in_jsmn->frc;
+    else if(!in_jsmn->fstat) rc=52; // Nothing was fed
+    else if(in_jsmn->foff+in_jsmn->b->cnt < 2) rc=53;
+
+    if(!rc) rc=vj_feed_parse(in_jsmn, in_jsmn->b->cnt);
+    if(!rc && in_jsmn->tcnt==JSMN_ERROR_PART) rc=17322; // Unexpected and of the json
+
+    if(!rc && in_jsmn->fstat == 3) { // Empty root - like v2_jsmn_parse() does
+	v2_json_free_box(in_jsmn->box);
+	free(in_jsmn->box);
+	in_jsmn->box=NULL;
+    }
+    if(!rc && in_jsmn->box) in_jsmn->json=in_jsmn->box->lst; // Copy pointer to main value
+
+    in_jsmn->fstat=0; // Next feed starts new json
+    in_jsmn->frc=0;
+    in_jsmn->fdep=0;
+    in_jsmn->foff=0;
+    in_jsmn->fname=NULL;
+    v2_wrbuf_reset(in_jsmn->b);
+
+    return(rc);
+}
+/* ========================================================================= */
+int v2_jsmn_feed_file(v2_jsmn_t *in_jsmn, char *in_file) {
+    char buffer[V2_WRBUF_BLOCK];
+    FILE *cf=stdin;
+    size_t reds=0;
+    int rc=0;
+    int rc1=0;
+
+    if(!in_jsmn) return(17300);
+    if(!in_file || !in_file[0]) return(0);
+
+    if(strcmp(in_file, "-")) {
+	if(!(cf=fopen(in_file, "r"))) return(17326);
+    }
+
+    while(!rc && (reds=fread(buffer, 1, V2_WRBUF_BLOCK, cf))) {
+	rc=v2_jsmn_feed(in_jsmn, buffer, reds);
+    }
+    if(!rc && ferror(cf)) rc=17327;
+
+    if(cf!=stdin) fclose(cf);
+
+    rc1=v2_jsmn_finish(in_jsmn); // Resets chunked state in any case
+
+    return(rc?rc:rc1);
+}
+/* ========================================================================= */
+// One record of v2_jsmn_lines(): parse in_rec (in_rec[in_len] is changed to '\0') and call in_fun
+static int vj_lines_rec(v2_jsmn_t *in_jsmn, char *in_rec, size_t in_len, int (*in_fun)(v2_jsmn_t *, void *), void *in_data) {
+    wrbuf_t *b=in_jsmn->b;
+    wrbuf_t rec;
+    int rc=0;
+
+    while(in_len && strchr(" \t\r", *in_rec))         { in_rec++; in_len--; }
+    while(in_len && strchr(" \t\r", in_rec[in_len-1])) in_len--;
+    if(!in_len) return(0); // Empty line
+    in_rec[in_len]='\0';
+
+    jsmn_init(&in_jsmn->parser); // Tokens and tape arrays are kept
+    in_jsmn->tcnt     = 0;
+    in_jsmn->tcur     = 0;
+    in_jsmn->tape.cnt = 0;
+    in_jsmn->json     = NULL;
+    in_jsmn->none     = 0;
+    in_jsmn->root     = JS_NONE;
+    if(in_jsmn->box && (rc=v2_json_new(&in_jsmn->box))) return(rc); // Slabs of previous record are reused
+
+    memset(&rec, 0, sizeof(wrbuf_t)); // Text of record in place
+    rec.buf=rec.pos=in_rec;
+    rec.cnt=rec.yet=rec.siz=in_len;
+
+    in_jsmn->b=&rec;
+    if(!(rc=v2_jsmn_parse_any(in_jsmn)) && in_fun) rc=in_fun(in_jsmn, in_data);
+    in_jsmn->b=b;
+
+    return(rc);
+}
+/* ========================================================================= */
+int v2_jsmn_lines(v2_jsmn_t *in_jsmn, char *in_file, int (*in_fun)(v2_jsmn_t *, void *), void *in_data) {
+    char buffer[V2_WRBUF_BLOCK];
+    FILE *cf=stdin;
+    char *end=NULL;
+    size_t reds=0;
+    size_t seen=0; // Bytes of b without new line
+    size_t done=0; // Bytes of b used by records
+    int rc=0;
+
+    if(!in_jsmn) return(17300);
+    if(!in_file || !in_file[0]) return(0);
+
+    if(strcmp(in_file, "-")) {
+	if(!(cf=fopen(in_file, "r"))) return(17326);
+    }
+
+    if(!(rc=v2_jsmn_init(in_jsmn))) rc=v2_wrbuf_new(&in_jsmn->b);
+    in_jsmn->lines = 1;
+    in_jsmn->lnum  = 0;
+    if(!rc && !in_jsmn->box) rc=v2_json_new(&in_jsmn->box);
+    if(!rc) in_jsmn->box->reuse=1;
+
+    while(!rc && (reds=fread(buffer, 1, V2_WRBUF_BLOCK, cf))) {
+	if(v2_wrbuf_write(in_jsmn->b, buffer, 1, reds) != reds) { rc=17325; break; }
+
+	for(done=0; !rc && (end=memchr(in_jsmn->b->buf+seen, '\n', in_jsmn->b->cnt-seen)); done=seen) {
+	    seen=end-in_jsmn->b->buf+1;
+	    in_jsmn->lnum++;
+	    rc=vj_lines_rec(in_jsmn, in_jsmn->b->buf+done, end-in_jsmn->b->buf-done, in_fun, in_data);
+	}
+	if(!rc && done) {
+	    rc=v2_wrbuf_drop(in_jsmn->b, done);
+	    seen-=done;
+	}
+	if(!rc) seen=in_jsmn->b->cnt;
+    }
+    if(!rc && ferror(cf)) rc=17327;
+
+    if(!rc && in_jsmn->b->cnt) { // Last line without new line
+	in_jsmn->lnum++;
+	rc=vj_lines_rec(in_jsmn, in_jsmn->b->buf, in_jsmn->b->cnt, in_fun, in_data);
+    }
+
+    if(cf!=stdin) fclose(cf);
+
+    in_jsmn->lines=0;
+    if(in_jsmn->box) in_jsmn->box->reuse=0; // Pool is freed by next v2_json_free_box()
+    v2_wrbuf_reset(in_jsmn->b);
+
+    return(rc);
+}
+/* ========================================================================= */
+/* On-demand access                                                          */
+/* ========================================================================= */
+// Next path part: its length, *p_path moves to the next one
+static size_t vj_path_next(char **p_path) {
+    char *p=*p_path;
+    size_t len=0;
+
+    while(p[len] && p[len] != '.') len++;
+    *p_path = p[len]?p+len+1:p+len;
+
+    return(len);
+}
+/* ========================================================================= */
+// Array index by path part, -1 if it is not a number
+static long vj_path_index(char *in_part, size_t in_len) {
+    long idx=0;
+    size_t x=0;
+
+    if(!in_len) return(-1);
+    for(x=0; x<in_len; x++) {
+	if(in_part[x] < '0' || in_part[x] > '9') return(-1);
+	idx=idx*10+(in_part[x]-'0');
+    }
+    return(idx);
+}
+/* ========================================================================= */
+// Tape word after value at in_x
+static size_t vj_tape_skip(v2_tape_t *in_tape, size_t in_x) {
+    char type=V2_TAPE_TYPE(in_tape->w[in_x]);
+
+    if(type == '{' || type == '[') return(V2_TAPE_VAL(in_tape->w[in_x])+1);
+    return(in_x+1);
+}
+/* ========================================================================= */
+// Tape index of value by path, (size_t)-1 - not found
+static size_t vj_tape_find(v2_jsmn_t *in_jsmn, char *in_path) {
+    char buf[256];
+    char *name=NULL;
+    v2_tape_t *tape=&in_jsmn->tape;
+    const char *js=in_jsmn->b->pos;
+    size_t js_len=in_jsmn->b->yet;
+    char *part=NULL;
+    size_t plen=0;
+    size_t klen=0;
+    size_t nlen=0;
+    size_t x=0;
+    size_t y=0;
+    size_t end=0;
+    long idx=0;
+
+    while(*in_path) {
+	part=in_path;
+	plen=vj_path_next(&in_path);
+	end=V2_TAPE_VAL(tape->w[x]); // Close word of container
+
+	if(V2_TAPE_TYPE(tape->w[x]) == '{') {
+	    for(y=x+1; y<end; y=vj_tape_skip(tape, y+1)) { // Name, value
+		klen=v2_tape_len(js, js_len, tape->w[y]);
+		if(!memchr(js+V2_TAPE_VAL(tape->w[y]), '\\', klen)) { // Most names - as is
+		    if(klen == plen && !memcmp(js+V2_TAPE_VAL(tape->w[y]), part, plen)) break;
+		} else {
+		    if(!(name=vj_unescape_tmp(buf, sizeof(buf), js+V2_TAPE_VAL(tape->w[y]), klen, &nlen))) return((size_t)-1);
+		    klen=(nlen == plen && !memcmp(name, part, plen));
+		    if(name != buf) free(name);
+		    if(klen) break;
+		}
+	    }
+	    if(y >= end) return((size_t)-1);
+	    x=y+1;
+	} else if(V2_TAPE_TYPE(tape->w[x]) == '[') {
+	    if((idx=vj_path_index(part, plen)) < 0) return((size_t)-1);
+	    for(y=x+1; y<end && idx; y=vj_tape_skip(tape, y)) idx--;
+	    if(y >= end) return((size_t)-1);
+	    x=y;
+	} else {
+	    return((size_t)-1); // Path goes into scalar
+	}
+    }
+
+    return(x);
+}
+/* ========================================================================= */
+// The same by built json, NULL - not found
+static json_lst_t *vj_json_find(v2_jsmn_t *in_jsmn, char *in_path) {
+    json_lst_t *jsn=in_jsmn->json;
+    json_lst_t *lst=NULL;
+    char *part=NULL;
+    size_t plen=0;
+    long idx=0;
+
+    // Root object has no node, root array has one
+    if(in_jsmn->root == JS_ARRAY) {
+	lst=jsn->child;
+    } else {
+	lst=jsn;
+	jsn=NULL;
+    }
+
+    while(*in_path) {
+	part=in_path;
+	plen=vj_path_next(&in_path);
+
+	if(jsn && jsn->js_type == JS_ARRAY) {
+	    if((idx=vj_path_index(part, plen)) < 0) return(NULL);
+	    lst=v2_json_at(in_jsmn->box, jsn, idx);
+	} else if(!jsn || jsn->js_type == JS_OBJECT) {
+	    for(; lst; lst=lst->next) {
+		if(!strncmp(lst->id, part, plen) && !lst->id[plen]) break;
+	    }
+	} else {
+	    return(NULL); // Path goes into scalar
+	}
+	if(!(jsn=lst)) return(NULL);
+	lst=jsn->child;
+    }
+
+    return(jsn);
+}
+/* ========================================================================= */
+// Raw value text by path: string without quotas (not unescaped) or primitive
+int v2_jsmn_get(v2_jsmn_t *in_jsmn, char *in_path, const char **p_val, size_t *p_len) {
+    size_t x=0;
+    uint64_t w=0;
+
+    if(!in_jsmn || !in_path || !p_val || !p_len) return(17300);
+    if(!in_jsmn->tape.cnt || !in_jsmn->b || !in_jsmn->b->cnt) return(17344); // No tape or text - not lazy parse
+    if((x=vj_tape_find(in_jsmn, in_path)) == (size_t)-1) return(17343);
+
+    w=in_jsmn->tape.w[x];
+    if(V2_TAPE_TYPE(w) == '{' || V2_TAPE_TYPE(w) == '[') return(17345); // Tape keeps no text of containers
+
+    *p_val=in_jsmn->b->pos+V2_TAPE_VAL(w);
+    *p_len=v2_tape_len(in_jsmn->b->pos, in_jsmn->b->yet, w);
+
+    return(0);
+}
+/* ========================================================================= */
+// Value by path: tape word (lazy parse) or json node, JS_NONE - not found
+static json_field vj_get_any(v2_jsmn_t *in_jsmn, char *in_path, const char **p_val, size_t *p_len, long long *p_lnum, double *p_dnum, json_lst_t **p_json) {
+    size_t x=0;
+    uint64_t w=0;
+
+    *p_json=NULL;
+
+    if(!in_jsmn || !in_path) return(JS_NONE);
+
+    if(in_jsmn->tape.cnt && in_jsmn->b && in_jsmn->b->cnt) {
+	if((x=vj_tape_find(in_jsmn, in_path)) == (size_t)-1) return(JS_NONE);
+	w=in_jsmn->tape.w[x];
+	*p_val=in_jsmn->b->pos;
+	*p_len=0;
+
+	switch(V2_TAPE_TYPE(w)) {
+	case '{': return(V2_TAPE_VAL(w) == x+1 ? JS_NULL : JS_OBJECT); // Object can not be empty - as v2_json_end() does
+	case '[': return(JS_ARRAY);
+	}
+
+	*p_val=in_jsmn->b->pos+V2_TAPE_VAL(w);
+	*p_len=v2_tape_len(in_jsmn->b->pos, in_jsmn->b->yet, w);
+
+	if(V2_TAPE_TYPE(w) == '"') return(JS_STRING);
+	if(**p_val == 'n') return(JS_NULL); // Primitive - the same as builder
+	if(**p_val == 't' || **p_val == 'f') return(JS_BOOLEAN);
+	return(vj_num(*p_val, *p_len, p_lnum, p_dnum));
+    }
+
+    if(!in_jsmn->json) return(JS_NONE);
+    if(!(*p_json=vj_json_find(in_jsmn, in_path))) return(JS_NONE);
+
+    switch((*p_json)->js_type) {
+    case JS_BOOLEAN:
+    case JS_INT:
+	*p_lnum=(*p_json)->num;
+	*p_dnum=(*p_json)->num;
+	break;
+    case JS_LONG:
+	*p_lnum=(*p_json)->lnum;
+	*p_dnum=(*p_json)->lnum;
+	break;
+    case JS_DOUBLE:
+	*p_lnum=(long long)(*p_json)->dnum;
+	*p_dnum=(*p_json)->dnum;
+	break;
+    default:
+	break;
+    }
+
+    return((*p_json)->js_type);
+}
+/* ========================================================================= */
+json_field v2_jsmn_get_type(v2_jsmn_t *in_jsmn, char *in_path) {
+    json_lst_t *jsn=NULL;
+    const char *val=NULL;
+    size_t len=0;
+    long long lnum=0;
+    double dnum=0;
+
+    return(vj_get_any(in_jsmn, in_path, &val, &len, &lnum, &dnum, &jsn));
+}
+/* ========================================================================= */
+char *v2_jsmn_get_str(v2_jsmn_t *in_jsmn, char *in_path, char *out_str, size_t out_size) {
+    json_lst_t *jsn=NULL;
+    const char *val=NULL;
+    size_t len=0;
+    long long lnum=0;
+    double dnum=0;
+
+    if(!out_str || !out_size) return(NULL);
+
+    switch(vj_get_any(in_jsmn, in_path, &val, &len, &lnum, &dnum, &jsn)) {
+    case JS_NONE:
+    case JS_OBJECT:
+    case JS_ARRAY:
+	return(NULL);
+    default:
+	if(jsn) v2_json_scalar(jsn, out_str, out_size); // Numbers are formatted here
+	else    return(vj_get_text(in_jsmn, out_str, out_size, val-in_jsmn->b->pos, len)); // Unescape only this one
+    }
+    return(out_str);
+}
+/* ========================================================================= */
+long long v2_jsmn_get_lint(v2_jsmn_t *in_jsmn, char *in_path, long long in_def) {
+    json_lst_t *jsn=NULL;
+    const char *val=NULL;
+    size_t len=0;
+    long long lnum=0;
+    double dnum=0;
+
+    switch(vj_get_any(in_jsmn, in_path, &val, &len, &lnum, &dnum, &jsn)) {
+    case JS_INT:
+    case JS_LONG:
+    case JS_DOUBLE:
+	return(lnum);
+    case JS_BOOLEAN:
+	return(jsn?jsn->num:(*val == 't'));
+    default:
+	return(in_def);
+    }
+}
+/* ========================================================================= */
+double v2_jsmn_get_double(v2_jsmn_t *in_jsmn, char *in_path, double in_def) {
+    json_lst_t *jsn=NULL;
+    const char *val=NULL;
+    size_t len=0;
+    long long lnum=0;
+    double dnum=0;
+
+    switch(vj_get_any(in_jsmn, in_path, &val, &len, &lnum, &dnum, &jsn)) {
+    case JS_INT:
+    case JS_LONG:
+    case JS_DOUBLE:
+	return(dnum);
+    default:
+	return(in_def);
+    }
+}
+/* ========================================================================= */
+int v2_jsmn_get_bool(v2_jsmn_t *in_jsmn, char *in_path, int in_def) {
+    json_lst_t *jsn=NULL;
+    const char *val=NULL;
+    size_t len=0;
+    long long lnum=0;
+    double dnum=0;
+
+    if(vj_get_any(in_jsmn, in_path, &val, &len, &lnum, &dnum, &jsn) != JS_BOOLEAN) return(in_def);
+
+    return(jsn?jsn->num:(*val == 't'));
+}
+/* ========================================================================= */
 // Add to debug diagnostics info
 int v2_jsmn_warn(v2_jsmn_t *in_jsmn) {
 
@@ -258,6 +1163,10 @@ int v2_jsmn_warn(v2_jsmn_t *in_jsmn) {
     v2_add_warn("V2_JSMN_DEBUG: box:    = %s", in_jsmn->box?"Allocated":"NULL");
     v2_add_warn("V2_JSMN_DEBUG: json:   = %s", in_jsmn->json?"Allocated":"NULL");
     v2_add_warn("V2_JSMN_DEBUG: tokens: = %s", in_jsmn->tokens?"Allocated":"NULL");
+    if(in_jsmn->b && in_jsmn->b->cnt) { // Memory per input byte
+	v2_add_warn("V2_JSMN_DEBUG: tokens  = %d (%.2f bytes per input byte)", in_jsmn->tmax, (double)in_jsmn->tmax*sizeof(jsmntok_t)/in_jsmn->b->cnt);
+	v2_add_warn("V2_JSMN_DEBUG: tape    = %zu (%.2f bytes per input byte)", in_jsmn->tape.max, (double)in_jsmn->tape.max*sizeof(uint64_t)/in_jsmn->b->cnt);
+    }
     v2_add_warn("V2_JSMN_DEBUG: locale: = %s", v2_st(in_jsmn->locale, "NULL"));
 
     return(0);
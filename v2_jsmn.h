@@ -22,9 +22,24 @@
 // Not JSON into buffer
 #define V2_NO_JSMN 17312
 
+// Tokenizer backends - v2_jsmn_t.backend
+#define V2_JSMN_BACK_TAPE 0 // Structural indexer to tape (v2_sidx.h), falls back to jsmn_parse() tokens on broken json
+#define V2_JSMN_BACK_JSMN 1 // jsmn_parse() only, byte by byte
+#define V2_JSMN_BACK_SIDX 2 // Structural indexer to jsmn tokens, falls back to jsmn_parse() on broken json
+
+// Average json text bytes per token - first guess of tokens array size
+#define V2_JSMN_TOK_BYTES 8
+
+// Root array is built by v2_jsmn_t.threads threads if it has V2_JSMN_THREADS_MIN tape words or more
+#ifndef V2_JSMN_THREADS_MIN
+#define V2_JSMN_THREADS_MIN 65536
+#endif
+#define V2_JSMN_THREADS_MAX 64
+
 #include <stdlib.h>
 
 #include "v2_json.h"
+#include "v2_sidx.h"
 
 /*
  * WARNING!!! You have to add files jsnm.c and jsmn.h by Serge Zaitsev
@@ -46,20 +61,63 @@ typedef struct {
 
     char *locale; // Local locate to delocale it
 
+    int backend; // V2_JSMN_BACK_TAPE (default), V2_JSMN_BACK_JSMN or V2_JSMN_BACK_SIDX
+
+    v2_tape_t tape; // Parsed by V2_JSMN_BACK_TAPE, tape.cnt == 0 if tokens are used
+
+    int lazy; // 1 - parse makes tape only (no box), values are read by v2_jsmn_get*(), text is kept in b
+
+    int threads; // Builder threads for big root array (tape only), 0 or 1 - no threads
+
+    int lines;   // 1 - v2_jsmn_lines() is running: tokens, tape and box nodes are reused by records
+    size_t lnum; // Line number of current record
+
     int tmax; // Maximal allocated tokens
     int tcnt; // Tokens counter
     int tcur; // Current reading token
 
-} v2_jsmn_t;
+    int none; // Last "_array_NNNN" name number, from 0 for every json
 
+    json_field root; // JS_OBJECT or JS_ARRAY - type of root value, JS_NONE before parse
+
+    // Chunked input - v2_jsmn_feed()/v2_jsmn_finish()
+    int *fstk;    // Open containers (tokens indexes) the builder is inside
+    int fdep;     // Depth of fstk
+    int fmax;     // Allocated fstk size
+    char *fname;  // Object member name waiting for its value - box key, not freed
+    size_t foff;  // Bytes already dropped from b
+    int fstat;    // 0 - not started, 1 - building, 2 - root value done
+    int frc;      // First error, returned by every next call
+
+} v2_jsmn_t;
 
-extern v2_jsmn_t v2_jsmn; // Read Write buffer
 
 // ---------------------------------------------------------------------------------
-int v2_jsmn_init(v2_jsmn_t *in_jsmn);
+int v2_jsmn_init(v2_jsmn_t *in_jsmn); // Reset parser state, free tokens, tape and fstk - call it when parser is not needed
 
 int v2_jsmn_parse(v2_jsmn_t *in_jsmn); // Parse buffer
-int v2_jsmn_parse_file(v2_jsmn_t *in_jsmn, char *in_file); // Parse from file
+int v2_jsmn_parse_file(v2_jsmn_t *in_jsmn, char *in_file); // Parse from file, "-" - stdin by chunks
+
+// Chunked input: tokenize and build tree as data comes, consumed text is dropped from b
+int v2_jsmn_feed(v2_jsmn_t *in_jsmn, const char *in_data, size_t in_len); // Add next chunk
+int v2_jsmn_finish(v2_jsmn_t *in_jsmn); // No more data, sets json
+int v2_jsmn_feed_file(v2_jsmn_t *in_jsmn, char *in_file); // Feed whole file ("-" - stdin) by V2_WRBUF_BLOCK chunks
+
+// JSON Lines (NDJSON): every not empty line of in_file ("-" - stdin) is parsed and in_fun(in_jsmn, in_data) is called
+// box, json and v2_jsmn_get*() are valid into in_fun only. Stops on first error or not 0 of in_fun, lnum - its line
+int v2_jsmn_lines(v2_jsmn_t *in_jsmn, char *in_file, int (*in_fun)(v2_jsmn_t *, void *), void *in_data);
+// ---------------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------
+// On-demand access by path "part1.portion1.word1", array elements by number: "list.0.id", "" - root
+// Lazy parse: only asked value is unescaped or converted. Else built json is used.
+// Broken json can not be put to tape - then lazy parse builds json as usual.
+int v2_jsmn_get(v2_jsmn_t *in_jsmn, char *in_path, const char **p_val, size_t *p_len); // Raw text in b, lazy parse only
+json_field v2_jsmn_get_type(v2_jsmn_t *in_jsmn, char *in_path); // JS_NONE - not found
+char *v2_jsmn_get_str(v2_jsmn_t *in_jsmn, char *in_path, char *out_str, size_t out_size); // NULL - not found or not scalar
+long long v2_jsmn_get_lint(v2_jsmn_t *in_jsmn, char *in_path, long long in_def);
+double v2_jsmn_get_double(v2_jsmn_t *in_jsmn, char *in_path, double in_def);
+int v2_jsmn_get_bool(v2_jsmn_t *in_jsmn, char *in_path, int in_def);
 // ---------------------------------------------------------------------------------
 
 int v2_jsmn_warn(v2_jsmn_t *in_jsmn); // Add to debug status of structure
@@ -16,44 +16,466 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdint.h>
+#include <unistd.h> // getpid
+#include <fcntl.h>
+
 #include "v2_json.h"
 #include "v2_iconv.h"
-#include "utf8.h" // u8escape
+#include "v2_num.h" // v2_num_dtoa
+#include "v2_esc.h" // v2_esc
 
 // ERROR_CODE 173XX : 17350 - 17399
 
 json_box_t json_box; // Default box context
 
+// Elements vector of array (or object) for v2_json_at()
+typedef struct json_arr_s {
+    json_lst_t *json; // Container
+    json_lst_t **el;  // Its children in order
+    size_t cnt;
+    size_t max;
+} json_arr_t;
+
+#ifdef V2_JSON_COMPACT
+typedef struct json_fid_s {
+    json_lst_t *json;
+    char *full_id;
+} json_fid_t;
+
+#define V2_JSON_TEXT(j, s) // Compact node keeps value only
+#else
+#define V2_JSON_TEXT(j, s) ((j)->str=(s)) // Scalar as text besides its value - numbers get it by v2_json_value()
+#endif
+
+// Span of printed container in last text, off - from start of its parent span (or of all values)
+// Text inside it does not move with it, so spans of children stay right when it is copied
+typedef struct json_txt_s {
+    json_lst_t *json;
+    size_t off;
+    size_t len;
+    int spaces; // Indent it was printed with
+    int dirty;  // Changed since - print it again
+} json_txt_t;
+
+// Last text of v2_json_text() with keep_text, and spans of its containers
+typedef struct json_tc_s {
+    json_txt_t *txt; // Open addressing table of max (power of 2) slots
+    size_t max;
+    size_t cnt;
+    wrbuf_t tb;      // Last text, taken from output buffer by next v2_json_text()
+    size_t base;     // Where values start in it
+    char *tbuf;      // Buffer it was left in - output buffer changed since is not taken
+    size_t tlen;
+    int bad;         // Some span was not kept
+    // Printed with
+    json_lst_t *prn;
+    int ident;
+    int no_escape;
+    int (*boxstr)(struct json_box_s*, char *);
+    int (*str)(char *);
+} json_tc_t;
+
+// Open container while printing
+typedef struct {
+    json_lst_t *json;
+    size_t nabs; // Its start in new text
+    size_t oabs; // and in last one, (size_t)-1 - not there
+} json_prn_t;
+
 // External function
 //int (*v2_json_fun)(json_lst_t *in_json)=NULL;
 
 /* =================================================================== */
-int v2_json_free_el(json_lst_t **p_json) {
-    json_lst_t *jsn_tmp=NULL;
+// Arena: nodes and strings of box are cut from its slabs, all are freed at once
+static int v2_json_slab_free(json_slab_t **p_slab) {
+    json_slab_t *slab=NULL;
+
+    while((slab=(*p_slab))) {
+	(*p_slab)=slab->next;
+	free(slab);
+    }
+    return(0);
+}
+/* =================================================================== */
+void *v2_json_alloc(json_box_t *in_jbox, size_t in_size) {
+    json_slab_t *slab=NULL;
+    size_t siz=0;
+
+    in_size=(in_size+7) & ~(size_t)7; // Align for node numbers
+
+    if(in_jbox->slab && in_jbox->slab->cnt+in_size <= in_jbox->slab->siz) {
+	slab=in_jbox->slab;
+	slab->cnt+=in_size;
+	return(slab->data+slab->cnt-in_size);
+    }
+
+    if(in_jbox->spare && in_jbox->spare->siz >= in_size) { // Kept by v2_json_free_box() with reuse
+	slab=in_jbox->spare;
+	in_jbox->spare=slab->next;
+    } else {
+	siz=(in_size > V2_JSON_SLAB)?in_size:V2_JSON_SLAB;
+	if(!(slab=(json_slab_t *)malloc(sizeof(json_slab_t)+siz))) return(NULL);
+	slab->siz=siz;
+    }
+    slab->cnt=in_size;
+
+    if(in_jbox->slab && in_size > V2_JSON_SLAB/2) { // Big one - current slab still has room for small ones
+	slab->next=in_jbox->slab->next;
+	in_jbox->slab->next=slab;
+    } else {
+	slab->next=in_jbox->slab;
+	in_jbox->slab=slab;
+    }
+
+    return(slab->data);
+}
+/* =================================================================== */
+char *v2_json_strndup(json_box_t *in_jbox, const char *in_str, size_t in_len) {
+    char *out=NULL;
+
+    if(!in_str) return(NULL);
+    if(!(out=(char *)v2_json_alloc(in_jbox, in_len+1))) return(NULL);
+
+    memcpy(out, in_str, in_len);
+    out[in_len]='\0';
+
+    return(out);
+}
+/* =================================================================== */
+char *v2_json_strdup(json_box_t *in_jbox, const char *in_str) {
+
+    if(!in_str) return(NULL);
+    return(v2_json_strndup(in_jbox, in_str, strlen(in_str)));
+}
+/* =================================================================== */
+// FNV-1a
+static size_t v2_json_hash(const char *in_str, size_t in_len) {
+    uint64_t h=14695981039346656037ULL;
+    size_t x=0;
+
+    for(x=0; x<in_len; x++) {
+	h^=(unsigned char)in_str[x];
+	h*=1099511628211ULL;
+    }
+    return((size_t)h);
+}
+/* =================================================================== */
+// Node pointer hash - high bits of product folded down, low bits of pointers are alike
+static size_t v2_json_ptr_hash(const void *in_ptr) {
+    uint64_t h=(uintptr_t)in_ptr*0x9E3779B97F4A7C15ULL;
+
+    return((size_t)(h ^ (h >> 32)));
+}
+/* =================================================================== */
+// Interned id: one string per distinct id of box, so ids of box nodes are equal if pointers are equal
+char *v2_json_key(json_box_t *in_jbox, const char *in_id, size_t in_len) {
+    char **keys=NULL;
+    size_t max=0;
+    size_t x=0;
+    size_t i=0;
+
+    if(!in_jbox || !in_id) return(NULL);
+
+    if((in_jbox->kcnt+1)*2 > in_jbox->kmax) { // Keep it half empty
+	max=in_jbox->kmax?in_jbox->kmax*2:256;
+	if(!(keys=(char **)calloc(max, sizeof(char *)))) return(NULL);
+
+	for(x=0; x<in_jbox->kmax; x++) {
+	    if(!in_jbox->keys[x]) continue;
+	    for(i=v2_json_hash(in_jbox->keys[x], strlen(in_jbox->keys[x])) & (max-1); keys[i]; i=(i+1) & (max-1));
+	    keys[i]=in_jbox->keys[x];
+	}
+	free(in_jbox->keys);
+	in_jbox->keys=keys;
+	in_jbox->kmax=max;
+    }
+
+    for(i=v2_json_hash(in_id, in_len) & (in_jbox->kmax-1); in_jbox->keys[i]; i=(i+1) & (in_jbox->kmax-1)) {
+	if(in_jbox->keys[i] == in_id) return(in_jbox->keys[i]); // Interned already
+	if(!memcmp(in_jbox->keys[i], in_id, in_len) && !in_jbox->keys[i][in_len]) return(in_jbox->keys[i]);
+    }
+
+    if(!(in_jbox->keys[i]=v2_json_strndup(in_jbox, in_id, in_len))) return(NULL);
+    in_jbox->kcnt++;
+
+    return(in_jbox->keys[i]);
+}
+/* =================================================================== */
+// Elements vectors are dropped, in_keep = 1 - table is kept for next values
+static int v2_json_arr_free(json_box_t *in_jbox, int in_keep) {
+    size_t x=0;
+
+    for(x=0; x<in_jbox->amax; x++) free(in_jbox->arr[x].el);
+
+    if(in_keep && in_jbox->arr) {
+	memset(in_jbox->arr, 0, in_jbox->amax*sizeof(json_arr_t));
+    } else {
+	free(in_jbox->arr);
+	in_jbox->arr=NULL;
+	in_jbox->amax=0;
+    }
+    in_jbox->acnt=0;
+
+    return(0);
+}
+/* =================================================================== */
+// Kept text: container spans by node pointer
+static json_txt_t *v2_json_txt_slot(json_tc_t *in_tc, json_lst_t *in_json) {
+    size_t i=0;
+
+    for(i=v2_json_ptr_hash(in_json) & (in_tc->max-1); in_tc->txt[i].json; i=(i+1) & (in_tc->max-1)) {
+	if(in_tc->txt[i].json == in_json) break;
+    }
+    return(&in_tc->txt[i]);
+}
+/* =================================================================== */
+static json_txt_t *v2_json_txt_get(json_tc_t *in_tc, json_lst_t *in_json) {
+    json_txt_t *txt=NULL;
+
+    if(!in_tc->cnt) return(NULL);
+
+    txt=v2_json_txt_slot(in_tc, in_json);
+    return(txt->json?txt:NULL);
+}
+/* =================================================================== */
+static json_txt_t *v2_json_txt_set(json_tc_t *in_tc, json_lst_t *in_json) {
+    json_txt_t *old=NULL;
+    json_txt_t *txt=NULL;
+    size_t max=0;
+    size_t x=0;
+
+    if((in_tc->cnt+1)*2 > in_tc->max) { // Keep it half empty
+	old=in_tc->txt;
+	max=in_tc->max;
+
+	in_tc->max=max?max*2:256;
+	if(!(in_tc->txt=(json_txt_t *)calloc(in_tc->max, sizeof(json_txt_t)))) {
+	    in_tc->txt=old;
+	    in_tc->max=max;
+	    return(NULL);
+	}
+	for(x=0; x<max; x++) {
+	    if(old[x].json) *v2_json_txt_slot(in_tc, old[x].json)=old[x];
+	}
+	free(old);
+    }
+
+    if(!(txt=v2_json_txt_slot(in_tc, in_json))->json) {
+	txt->json=in_json;
+	in_tc->cnt++;
+    }
+    return(txt);
+}
+/* =================================================================== */
+static int v2_json_txt_clean(json_tc_t *in_tc) {
+
+    if(in_tc->txt) memset(in_tc->txt, 0, in_tc->max*sizeof(json_txt_t));
+    in_tc->cnt=0;
+    in_tc->bad=0;
+
+    return(0);
+}
+/* =================================================================== */
+static int v2_json_tc_free(json_box_t *in_jbox) {
+
+    if(!in_jbox->tc) return(0);
+
+    free(in_jbox->tc->txt);
+    v2_wrbuf_reset(&in_jbox->tc->tb);
+    free(in_jbox->tc);
+    in_jbox->tc=NULL;
 
-    if(!p_json) return(0);
+    return(0);
+}
+/* =================================================================== */
+// Lookup index: node by parent pointer and id, made by first v2_json_find() or v2_json_child()
+// Slot of (in_par, in_id[in_len]) node - or empty slot to put it
+static size_t v2_json_idx_slot(json_box_t *in_jbox, json_lst_t *in_par, const char *in_id, size_t in_len) {
+    json_lst_t *json_tmp=NULL;
+    size_t i=0;
 
-    while((jsn_tmp=(*p_json))) {
-        (*p_json)=(*p_json)->next;
+    i=(v2_json_hash(in_id, in_len) ^ v2_json_ptr_hash(in_par)) & (in_jbox->imax-1);
+
+    for(; (json_tmp=in_jbox->idx[i]); i=(i+1) & (in_jbox->imax-1)) {
+	if(json_tmp->parent != in_par) continue;
+	if(json_tmp->id == in_id) break; // Interned id
+	if(!strncmp(json_tmp->id, in_id, in_len) && !json_tmp->id[in_len]) break;
+    }
+    return(i);
+}
+/* =================================================================== */
+static int v2_json_idx_add(json_box_t *in_jbox, json_lst_t *in_json) {
+    json_lst_t **old=NULL;
+    size_t max=0;
+    size_t x=0;
+    size_t i=0;
+
+    if(!in_json->id) return(0);
+
+    if((in_jbox->icnt+1)*2 > in_jbox->imax) { // Keep it half empty
+	old=in_jbox->idx;
+	max=in_jbox->imax;
+
+	in_jbox->imax=max?max*2:256;
+	if(!(in_jbox->idx=(json_lst_t **)calloc(in_jbox->imax, sizeof(json_lst_t *)))) {
+	    in_jbox->idx=old;
+	    in_jbox->imax=max;
+	    return(17362);
+	}
+	for(x=0; x<max; x++) {
+	    if(!old[x]) continue;
+	    in_jbox->idx[v2_json_idx_slot(in_jbox, old[x]->parent, old[x]->id, strlen(old[x]->id))]=old[x];
+	}
+	free(old);
+    }
+
+    i=v2_json_idx_slot(in_jbox, in_json->parent, in_json->id, strlen(in_json->id));
+    if(in_jbox->idx[i]) return(0); // The same name again - the first one is found
+    in_jbox->idx[i]=in_json;
+    in_jbox->icnt++;
+
+    return(0);
+}
+/* =================================================================== */
+static int v2_json_idx_free(json_box_t *in_jbox) {
+
+    free(in_jbox->idx);
+    in_jbox->idx    = NULL;
+    in_jbox->imax   = 0;
+    in_jbox->icnt   = 0;
+    in_jbox->is_idx = 0;
+
+    return(0);
+}
+/* =================================================================== */
+// All nodes to index, in text order - containers are kept on stack, parent of shared values is not in this box
+static int v2_json_idx_make(json_box_t *in_jbox) {
+    json_lst_t *json_tmp=NULL;
+    json_lst_t **stk=NULL;
+    json_lst_t **stk_tmp=NULL;
+    size_t dep=0;
+    size_t max=0;
+    int rc=0;
 
-	v2_json_free_el(&jsn_tmp->child);
-        v2_freestr(&jsn_tmp->id);
-	v2_freestr(&jsn_tmp->str);
+    for(json_tmp=in_jbox->lst; json_tmp; ) {
+	if((rc=v2_json_idx_add(in_jbox, json_tmp))) break;
+
+	if(json_tmp->child) {
+	    if(dep == max) {
+		if(!(stk_tmp=(json_lst_t **)realloc(stk, (max?max*2:64)*sizeof(json_lst_t *)))) {
+		    rc=17362;
+		    break;
+		}
+		stk=stk_tmp;
+		max=max?max*2:64;
+	    }
+	    stk[dep++]=json_tmp;
+	    json_tmp=json_tmp->child;
+	    continue;
+	}
+	while(json_tmp && !json_tmp->next) json_tmp=dep?stk[--dep]:NULL;
+	if(json_tmp) json_tmp=json_tmp->next;
+    }
+    free(stk);
 
-        // Free jsn_tmp?
-	free(jsn_tmp);
+    if(rc) {
+	v2_json_idx_free(in_jbox);
+	return(rc);
     }
+    in_jbox->is_idx=1;
 
     return(0);
 }
 /* =================================================================== */
+// Member in_id of in_json object (or array - "_array_NNNN"), NULL in_json - root value
+json_lst_t *v2_json_child(json_box_t *in_jbox, json_lst_t *in_json, char *in_id) {
+    json_lst_t *json_tmp=NULL;
+
+    if(!in_jbox || !in_id) return(NULL);
+    if(!in_jbox->is_idx && v2_json_idx_make(in_jbox)) return(NULL);
+    if(!in_jbox->icnt) return(NULL);
+
+    if(in_json && in_json->child) in_json=in_json->child->parent; // Shared values have their own parent
+
+    json_tmp=in_jbox->idx[v2_json_idx_slot(in_jbox, in_json, in_id, strlen(in_id))];
+
+    return(json_tmp);
+}
+/* =================================================================== */
+// Node by full ID like "part1.portion1.word1"
+json_lst_t *v2_json_find(json_box_t *in_jbox, char *in_path) {
+    json_lst_t *json_tmp=NULL;
+    char *dot=NULL;
+
+    if(!in_jbox || !in_path) return(NULL);
+    if(!in_jbox->is_idx && v2_json_idx_make(in_jbox)) return(NULL);
+    if(!in_jbox->icnt) return(NULL);
+
+    for(;; in_path=dot+1) {
+	dot=strchr(in_path, '.');
+	if(json_tmp && json_tmp->child) json_tmp=json_tmp->child->parent; // Shared values have their own parent
+	json_tmp=in_jbox->idx[v2_json_idx_slot(in_jbox, json_tmp, in_path, dot?(size_t)(dot-in_path):strlen(in_path))];
+	if(!json_tmp || !dot) break;
+    }
+
+    return(json_tmp);
+}
+/* =================================================================== */
 int v2_json_free_box(json_box_t *in_jbox) {
+    json_slab_t *slab=NULL;
+
+    if(in_jbox->reuse) { // Keep slabs for next values
+	while((slab=in_jbox->slab)) {
+	    in_jbox->slab=slab->next;
+	    slab->next=in_jbox->spare;
+	    in_jbox->spare=slab;
+	}
+    } else {
+	v2_json_slab_free(&in_jbox->slab);
+	v2_json_slab_free(&in_jbox->spare);
+    }
+
+    if(in_jbox->reuse && in_jbox->keys) { // Strings were in slabs
+	memset(in_jbox->keys, 0, in_jbox->kmax*sizeof(char *));
+    } else {
+	free(in_jbox->keys);
+	in_jbox->keys=NULL;
+	in_jbox->kmax=0;
+    }
+    in_jbox->kcnt=0;
+
+    if(in_jbox->reuse && in_jbox->idx) memset(in_jbox->idx, 0, in_jbox->imax*sizeof(json_lst_t *));
+    else                                v2_json_idx_free(in_jbox);
+    in_jbox->icnt=0;
+    in_jbox->is_idx=0;
+
+    v2_json_arr_free(in_jbox, in_jbox->reuse);
+    v2_json_tc_free(in_jbox);
+
+    while(in_jbox->rcnt) v2_json_unref(&in_jbox->refs[--in_jbox->rcnt]); // Last owner frees them
+    if(!in_jbox->reuse) {
+	free(in_jbox->refs);
+	in_jbox->refs=NULL;
+	in_jbox->rmax=0;
+    }
+
+#ifdef V2_JSON_COMPACT
+    if(in_jbox->reuse && in_jbox->fid) {
+	memset(in_jbox->fid, 0, in_jbox->fmax*sizeof(json_fid_t));
+    } else {
+	free(in_jbox->fid);
+	in_jbox->fid=NULL;
+	in_jbox->fmax=0;
+    }
+    in_jbox->fcnt=0;
+#endif
 
-    v2_json_free_el(&in_jbox->lst);
     v2_json_locale(in_jbox, NULL, 0);
 
     v2_wrbuf_free(&in_jbox->b);
 
+    in_jbox->lst    = NULL;
     in_jbox->tek    = NULL;
     in_jbox->prn    = NULL; // Print point for printing
     in_jbox->chan   = NULL; // Chain of all named elements
@@ -66,6 +488,7 @@ int v2_json_free_box(json_box_t *in_jbox) {
     in_jbox->no_escape   = 0;
     in_jbox->no_fullid   = 0;
     in_jbox->no_clean    = 0;
+    in_jbox->keep_text   = 0;
 
     return(0);
 }
@@ -86,21 +509,25 @@ int v2_json_new(json_box_t **p_box) {
     return(0);
 }
 /* =================================================================== */
-int v2_json_iconv(json_box_t *in_jbox, char *in_str) {
-    char *out=NULL;
+// Locale converted copy of in_str (allocated), NULL if no conversion
+static char *v2_json_iconv_dup(json_box_t *in_jbox, char *in_str) {
 
-    if(!v2_is_par(in_str)) return(0);
+    if(!v2_is_par(in_str)) return(NULL);
 
-    if(!in_jbox)         return(0);
-    if(!in_jbox->locale) return(0);
+    if(!in_jbox)         return(NULL);
+    if(!in_jbox->locale) return(NULL);
 
-    if(in_jbox->is_delocale) {
-	if(!(out=v2_iconv("UTF-8", in_jbox->locale, in_str))) return(0);
-    } else {
-	if(!(out=v2_iconv(in_jbox->locale, "UTF-8", in_str))) return(0);
-    }
+    if(in_jbox->is_delocale) return(v2_iconv("UTF-8", in_jbox->locale, in_str));
+    return(v2_iconv(in_jbox->locale, "UTF-8", in_str));
+}
+/* =================================================================== */
+// boxstr() by locale - in place, in_str has V2_JSON_CNV_ROOM(strlen(in_str)) bytes, longer result is cut
+int v2_json_iconv(json_box_t *in_jbox, char *in_str) {
+    char *out=NULL;
 
-    sprintf(in_str, "%s", out);
+    if(!(out=v2_json_iconv_dup(in_jbox, in_str))) return(0);
+
+    snprintf(in_str, V2_JSON_CNV_ROOM(strlen(in_str)), "%s", out);
 
     v2_freestr(&out);
     return(0);
@@ -132,6 +559,8 @@ int v2_json_none_lst(json_lst_t *in_json) {
 	json_box.tek=NULL;
     }
 
+    v2_json_touch(&json_box, in_json);
+
     FOR_LST(jsn_tmp, in_json) {
 	jsn_tmp->js_type=JS_NONE;
 	if((in_json==json_box.lst) && !jsn_tmp->next) json_box.tek=jsn_tmp;
@@ -169,6 +598,7 @@ int v2_json_add_json(json_box_t *in_jbox, json_lst_t *json_inp) {
 
     if(!in_jbox)  return(17351);
     if(!json_inp) return(17352);
+    if(json_inp->shared) return(17365); // Read only - v2_json_jref() adds it
 
     if(v2_json_is_parent(json_inp)) json_inp->open=1;
 
@@ -184,25 +614,33 @@ int v2_json_add_json(json_box_t *in_jbox, json_lst_t *json_inp) {
 	    in_jbox->tek->child->parent = in_jbox->tek;
 	} else {
 	    in_jbox->tek->next          = json_inp;
+#ifndef V2_JSON_COMPACT
 	    in_jbox->tek->next->prev    = in_jbox->tek;
+#endif
 	    in_jbox->tek->next->parent  = in_jbox->tek->parent;
 	}
     }
     in_jbox->tek = json_inp;
+#ifndef V2_JSON_COMPACT
+    json_inp->full_id=NULL; // New place - made again by v2_json_full_id()
+#endif
 
-    if(in_jbox->no_fullid) return(0);
+    if(in_jbox->tc) v2_json_touch(in_jbox, json_inp); // Its container is printed again
 
-    if(json_inp->parent) {
-	v2_let_varf(&json_inp->full_id, "%s.%s", json_inp->parent->full_id, json_inp->id);
-    } else {
-	v2_let_var(&json_inp->full_id ,json_inp->id);
+    if(in_jbox->is_idx) { // Lookup index is made already
+	if(json_inp->child)                          v2_json_idx_free(in_jbox); // Foreign subtree - make it again
+	else if(v2_json_idx_add(in_jbox, json_inp))  v2_json_idx_free(in_jbox);
     }
 
+    if(in_jbox->no_fullid) return(0);
+
     if(json_inp->open!=1) { // Not array or obj
 	if(!in_jbox->chan) {
 	    in_jbox->chan=json_inp; // Set first pointer and temporal one
 	} else {
+#ifndef V2_JSON_COMPACT
 	    in_jbox->ctek->list=json_inp; // Set next one
+#endif
 	}
 	in_jbox->ctek=json_inp;
     }
@@ -210,24 +648,557 @@ int v2_json_add_json(json_box_t *in_jbox, json_lst_t *json_inp) {
     return(0);
 }
 /* =================================================================== */
+// Parent of in_json - shared subtree root is not
+static json_lst_t *v2_json_up(json_lst_t *in_json) {
+    if(!in_json->parent || in_json->parent->shared == 2) return(NULL);
+    return(in_json->parent);
+}
+/* =================================================================== */
+// Full ID like "group.admin.name.first" by parent links to out_str[out_size]
+// Returns its length, out_str is empty if it does not fit
+size_t v2_json_path(json_lst_t *in_json, char *out_str, size_t out_size) {
+    json_lst_t *json_tmp=NULL;
+    const char *fid=NULL;
+    const char *str=NULL;
+    size_t len=0;
+    size_t pos=0;
+
+    for(json_tmp=in_json; json_tmp; json_tmp=v2_json_up(json_tmp)) {
+	if((fid=V2_JSON_FID(json_tmp))) { // Made already
+	    len+=strlen(fid);
+	    break;
+	}
+	len+=strlen(v2_nn(json_tmp->id))+(v2_json_up(json_tmp)?1:0);
+    }
+
+    if(!out_str || !out_size) return(len);
+    out_str[0]='\0';
+    if(len >= out_size)       return(len);
+
+    out_str[len]='\0';
+    for(json_tmp=in_json, pos=len; pos; json_tmp=v2_json_up(json_tmp)) { // From the end
+	fid=V2_JSON_FID(json_tmp);
+	str=fid?fid:v2_nn(json_tmp->id);
+	pos-=strlen(str);
+	memcpy(out_str+pos, str, strlen(str));
+	if(fid || !pos) break;
+	out_str[--pos]='.';
+    }
+
+    return(len);
+}
+/* =================================================================== */
+#ifdef V2_JSON_COMPACT
+// Slot of in_json full ID in box table
+static json_fid_t *v2_json_fid(json_box_t *in_jbox, json_lst_t *in_json) {
+    size_t i=0;
+
+    if(!in_jbox->fmax) return(NULL);
+
+    for(i=v2_json_ptr_hash(in_json) & (in_jbox->fmax-1); in_jbox->fid[i].json; i=(i+1) & (in_jbox->fmax-1)) {
+	if(in_jbox->fid[i].json == in_json) break;
+    }
+    return(&in_jbox->fid[i]);
+}
+/* =================================================================== */
+static char *v2_json_fid_get(json_box_t *in_jbox, json_lst_t *in_json) {
+    json_fid_t *fid=v2_json_fid(in_jbox, in_json);
+
+    return(fid?fid->full_id:NULL);
+}
+/* =================================================================== */
+static char *v2_json_fid_set(json_box_t *in_jbox, json_lst_t *in_json, char *in_fid) {
+    json_fid_t *old=NULL;
+    size_t max=0;
+    size_t x=0;
+
+    if((in_jbox->fcnt+1)*2 > in_jbox->fmax) { // Keep it half empty
+	old=in_jbox->fid;
+	max=in_jbox->fmax;
+
+	in_jbox->fmax=max?max*2:256;
+	if(!(in_jbox->fid=(json_fid_t *)calloc(in_jbox->fmax, sizeof(json_fid_t)))) {
+	    in_jbox->fid=old;
+	    in_jbox->fmax=max;
+	    return(NULL);
+	}
+	for(x=0; x<max; x++) {
+	    if(old[x].json) *v2_json_fid(in_jbox, old[x].json)=old[x];
+	}
+	free(old);
+    }
+
+    old=v2_json_fid(in_jbox, in_json);
+    old->json=in_json;
+    old->full_id=in_fid;
+    in_jbox->fcnt++;
+
+    return(in_fid);
+}
+#else
+#define v2_json_fid_get(b, j)    ((j)->full_id)
+#define v2_json_fid_set(b, j, f) ((j)->full_id=(f))
+#endif
+/* =================================================================== */
+// Full ID of node, made on first call and kept in node (box memory) - parents keep theirs too
+char *v2_json_full_id(json_box_t *in_jbox, json_lst_t *in_json) {
+    const char *par=NULL;
+    char *out=NULL;
+    size_t plen=0;
+    size_t ilen=0;
+
+    if(!in_jbox || !in_json) return(NULL);
+    if((out=v2_json_fid_get(in_jbox, in_json))) return(out);
+
+    if(in_json->shared) { // Read only - made again by each call
+	ilen=v2_json_path(in_json, NULL, 0);
+	if(!(out=(char *)v2_json_alloc(in_jbox, ilen+1))) return(NULL);
+	v2_json_path(in_json, out, ilen+1);
+	return(out);
+    }
+
+    if(in_json->parent && !(par=v2_json_full_id(in_jbox, in_json->parent))) return(NULL);
+
+    plen=par?strlen(par)+1:0; // "parent.id"
+    ilen=strlen(v2_nn(in_json->id));
+
+    if(!(out=(char *)v2_json_alloc(in_jbox, plen+ilen+1))) return(NULL);
+    if(par) {
+	memcpy(out, par, plen-1);
+	out[plen-1]='.';
+    }
+    memcpy(out+plen, v2_nn(in_json->id), ilen+1);
+
+    return(v2_json_fid_set(in_jbox, in_json, out));
+}
+/* =================================================================== */
+// Scalar value as text to out_str[out_size] - numbers keep binary value only
+char *v2_json_scalar(json_lst_t *in_json, char *out_str, size_t out_size) {
+    char num[V2_NUM_DTOA_LEN];
+
+    if(!out_str || !out_size) return(NULL);
+    out_str[0]='\0';
+    if(!in_json) return(out_str);
+
+    switch(in_json->js_type) {
+    case JS_STRING:
+	snprintf(out_str, out_size, "%s", v2_nn(V2_JSON_STR(in_json)));
+	break;
+    case JS_INT:
+	snprintf(out_str, out_size, "%d", in_json->num);
+	break;
+    case JS_LONG:
+	snprintf(out_str, out_size, "%lld", in_json->lnum);
+	break;
+    case JS_DOUBLE:
+	v2_num_dtoa(in_json->dnum, num);
+	snprintf(out_str, out_size, "%s", num); // As printed
+	break;
+    case JS_BOOLEAN:
+	snprintf(out_str, out_size, "%s", in_json->num?"true":"false");
+	break;
+    case JS_NULL:
+	snprintf(out_str, out_size, "null");
+	break;
+    default: // Containers have no text
+	break;
+    }
+    return(out_str);
+}
+/* =================================================================== */
+// Scalar value as text, numbers are formatted on first call - kept in node (compact one - in box memory only)
+char *v2_json_value(json_box_t *in_jbox, json_lst_t *in_json) {
+    char strtmp[64];
+    char *out=NULL;
+
+    if(!in_jbox || !in_json)        return(NULL);
+    if((out=V2_JSON_STR(in_json)))  return(out);
+    if(v2_json_is_parent(in_json))  return(NULL);
+
+    if(in_json->js_type == JS_STRING) return("");
+
+    if(!(out=v2_json_strdup(in_jbox, v2_json_scalar(in_json, strtmp, sizeof(strtmp))))) return(NULL);
+    if(!in_json->shared) V2_JSON_TEXT(in_json, out); // Shared node is read only
+
+    return(out);
+}
+/* =================================================================== */
+// Slot of in_json elements vector in box table
+static json_arr_t *v2_json_arr_slot(json_box_t *in_jbox, json_lst_t *in_json) {
+    size_t i=0;
+
+    for(i=v2_json_ptr_hash(in_json) & (in_jbox->amax-1); in_jbox->arr[i].json; i=(i+1) & (in_jbox->amax-1)) {
+	if(in_jbox->arr[i].json == in_json) break;
+    }
+    return(&in_jbox->arr[i]);
+}
+/* =================================================================== */
+// Elements vector of in_json, made on first call - values added later are appended by next calls
+static json_arr_t *v2_json_arr_get(json_box_t *in_jbox, json_lst_t *in_json) {
+    json_arr_t *old=NULL;
+    json_arr_t *arr=NULL;
+    json_lst_t *json_tmp=NULL;
+    json_lst_t **el=NULL;
+    size_t max=0;
+    size_t x=0;
+
+    if((in_jbox->acnt+1)*2 > in_jbox->amax) { // Keep it half empty
+	old=in_jbox->arr;
+	max=in_jbox->amax;
+
+	in_jbox->amax=max?max*2:64;
+	if(!(in_jbox->arr=(json_arr_t *)calloc(in_jbox->amax, sizeof(json_arr_t)))) {
+	    in_jbox->arr=old;
+	    in_jbox->amax=max;
+	    return(NULL);
+	}
+	for(x=0; x<max; x++) {
+	    if(old[x].json) *v2_json_arr_slot(in_jbox, old[x].json)=old[x];
+	}
+	free(old);
+    }
+
+    if(!(arr=v2_json_arr_slot(in_jbox, in_json))->json) {
+	arr->json=in_json;
+	in_jbox->acnt++;
+    }
+
+    json_tmp=arr->cnt?arr->el[arr->cnt-1]->next:in_json->child; // New ones
+    for(; json_tmp; json_tmp=json_tmp->next) {
+	if(arr->cnt == arr->max) {
+	    max=arr->max?arr->max*2:16;
+	    if(!(el=(json_lst_t **)realloc(arr->el, max*sizeof(json_lst_t *)))) return(NULL);
+	    arr->el=el;
+	    arr->max=max;
+	}
+	arr->el[arr->cnt++]=json_tmp;
+    }
+
+    return(arr);
+}
+/* =================================================================== */
+// Element in_idx of array (or member of object) in_json, by index vector kept in box
+json_lst_t *v2_json_at(json_box_t *in_jbox, json_lst_t *in_json, size_t in_idx) {
+    json_arr_t *arr=NULL;
+
+    if(!in_jbox || !v2_json_is_parent(in_json))   return(NULL);
+    if(!(arr=v2_json_arr_get(in_jbox, in_json)))  return(NULL);
+    if(in_idx >= arr->cnt)                        return(NULL);
+
+    return(arr->el[in_idx]);
+}
+/* =================================================================== */
+// Number of in_json children
+size_t v2_json_len(json_box_t *in_jbox, json_lst_t *in_json) {
+    json_arr_t *arr=NULL;
+
+    if(!in_jbox || !v2_json_is_parent(in_json))   return(0);
+    if(!(arr=v2_json_arr_get(in_jbox, in_json)))  return(0);
+
+    return(arr->cnt);
+}
+/* =================================================================== */
+json_lst_t *v2_json_prev(json_box_t *in_jbox, json_lst_t *in_json) {
+    json_lst_t *json_tmp=NULL;
+
+    if(!in_json) return(NULL);
+#ifndef V2_JSON_COMPACT
+    json_tmp=in_json->prev;
+#else
+    if(!in_jbox && !in_json->parent) return(NULL);
+
+    json_tmp=in_json->parent?in_json->parent->child:in_jbox->lst;
+    if(json_tmp == in_json) return(NULL);
+
+    for(; json_tmp && json_tmp->next != in_json; json_tmp=json_tmp->next);
+#endif
+
+    return(json_tmp);
+}
+/* =================================================================== */
+json_lst_t *v2_json_list(json_lst_t *in_json) {
+    json_lst_t *json_tmp=in_json;
+
+    if(!in_json) return(NULL);
+#ifndef V2_JSON_COMPACT
+    json_tmp=in_json->list;
+#else
+    while(json_tmp) { // Next one by text, scalars only - shared values (have their own parent) are not in chain
+	if(json_tmp->child && json_tmp->child->parent == json_tmp) {
+	    json_tmp=json_tmp->child;
+	} else {
+	    while(json_tmp && !json_tmp->next) json_tmp=json_tmp->parent;
+	    if(json_tmp) json_tmp=json_tmp->next;
+	}
+	if(json_tmp && !v2_json_is_parent(json_tmp) && json_tmp->open != 2) break;
+    }
+#endif
+
+    return(json_tmp);
+}
+/* =================================================================== */
 int v2_json_add_node(json_box_t *in_jbox, char *in_id, json_field js_type) {
     json_lst_t *json_tmp=NULL;
 
     if(!in_jbox) return(17361);
 
-    if(!(json_tmp=(json_lst_t *)calloc(sizeof(json_lst_t), 1))) return(17350);
+    if(!(json_tmp=(json_lst_t *)v2_json_alloc(in_jbox, sizeof(json_lst_t)))) return(17350);
+    memset(json_tmp, 0, sizeof(json_lst_t));
 
     if(in_id && *in_id) {
-	v2_let_var(&json_tmp->id, in_id);
+	json_tmp->id=v2_json_key(in_jbox, in_id, strlen(in_id));
     } else {
-	v2_let_varf(&json_tmp->id, "_obj_%04d", ++in_jbox->arr_no); // Check if parent id array
+	char strtmp[32];
+	json_tmp->id=v2_json_key(in_jbox, strtmp, snprintf(strtmp, sizeof(strtmp), "_obj_%04d", ++in_jbox->arr_no)); // Check if parent id array
     }
+    if(!json_tmp->id) return(17350);
 
     json_tmp->js_type=js_type;
 
     return(v2_json_add_json(in_jbox, json_tmp));
 }
 /* =================================================================== */
+// Shared subtrees: box values are moved to json_ref_t and made read only, boxes point to them
+// in_jbox owns one more in_ref - released by v2_json_free_box()
+static int v2_json_ref_keep(json_box_t *in_jbox, json_ref_t *in_ref) {
+    json_ref_t **refs=NULL;
+    size_t max=0;
+
+    if(in_jbox->rcnt == in_jbox->rmax) {
+	max=in_jbox->rmax?in_jbox->rmax*2:16;
+	if(!(refs=(json_ref_t **)realloc(in_jbox->refs, max*sizeof(json_ref_t *)))) return(17364);
+	in_jbox->refs=refs;
+	in_jbox->rmax=max;
+    }
+    in_jbox->refs[in_jbox->rcnt++]=in_ref;
+    __atomic_add_fetch(&in_ref->cnt, 1, __ATOMIC_RELAXED);
+
+    return(0);
+}
+/* =================================================================== */
+// Values of in_jbox to new shared subtree *p_ref (caller owns it), in_jbox keeps its settings and output only
+int v2_json_ref(json_box_t *in_jbox, json_ref_t **p_ref) {
+    json_ref_t *ref=NULL;
+    json_lst_t *node=NULL;
+
+    if(!in_jbox || !p_ref) return(17363);
+
+    if(!(ref=(json_ref_t *)calloc(1, sizeof(json_ref_t)))) return(17364);
+
+    // Values with their memory, ids, vectors and shared subtrees they have
+    ref->box.lst  = in_jbox->lst;
+    ref->box.slab = in_jbox->slab;
+    ref->box.keys = in_jbox->keys;
+    ref->box.kmax = in_jbox->kmax;
+    ref->box.kcnt = in_jbox->kcnt;
+    ref->box.arr  = in_jbox->arr;
+    ref->box.amax = in_jbox->amax;
+    ref->box.acnt = in_jbox->acnt;
+#ifdef V2_JSON_COMPACT
+    ref->box.fid  = in_jbox->fid;
+    ref->box.fmax = in_jbox->fmax;
+    ref->box.fcnt = in_jbox->fcnt;
+#endif
+    ref->box.refs = in_jbox->refs;
+    ref->box.rmax = in_jbox->rmax;
+    ref->box.rcnt = in_jbox->rcnt;
+
+    in_jbox->lst  = NULL;
+    in_jbox->tek  = NULL;
+    in_jbox->prn  = NULL;
+    in_jbox->chan = NULL;
+    in_jbox->ctek = NULL;
+    in_jbox->slab = NULL;
+    in_jbox->keys = NULL;
+    in_jbox->kmax = in_jbox->kcnt = 0;
+    v2_json_idx_free(in_jbox); // Root of values is changed
+    v2_json_tc_free(in_jbox);
+    in_jbox->arr  = NULL;
+    in_jbox->amax = in_jbox->acnt = 0;
+#ifdef V2_JSON_COMPACT
+    in_jbox->fid  = NULL;
+    in_jbox->fmax = in_jbox->fcnt = 0;
+#endif
+    in_jbox->refs = NULL;
+    in_jbox->rmax = in_jbox->rcnt = 0;
+    in_jbox->arr_no = 0;
+
+    if(!(ref->json=(json_lst_t *)v2_json_alloc(&ref->box, sizeof(json_lst_t)))) {
+	v2_json_free_box(&ref->box);
+	free(ref);
+	return(17364);
+    }
+    memset(ref->json, 0, sizeof(json_lst_t));
+    ref->json->js_type = JS_OBJECT;
+    ref->json->child   = ref->box.lst;
+    ref->json->shared  = 2;
+
+    for(node=ref->box.lst; node; node=node->next) node->parent=ref->json;
+
+    for(node=ref->box.lst; node; ) { // Read only now, other shared subtrees are marked already
+	node->shared=1;
+
+	if(node->child && node->child->parent == node) {
+	    node=node->child;
+	    continue;
+	}
+	while(node && !node->next) node=node->parent;
+	if(node) node=node->next;
+    }
+
+    ref->cnt=1;
+    *p_ref=ref;
+
+    return(0);
+}
+/* =================================================================== */
+// Add in_ref values as object in_id: no copy, in_jbox owns in_ref till v2_json_free_box()
+// Object is closed already - next value goes after it
+int v2_json_jref(json_box_t *in_jbox, char *in_id, json_ref_t *in_ref) {
+    int rc=0;
+
+    if(!in_jbox || !in_ref) return(17363);
+
+    if((rc=v2_json_ref_keep(in_jbox, in_ref)))            return(rc);
+    if((rc=v2_json_add_node(in_jbox, in_id, JS_OBJECT)))  return(rc);
+
+    in_jbox->tek->open  = 0;
+    in_jbox->tek->child = in_ref->json->child; // Their parent is in_ref root - nodes are not changed
+
+    if(in_jbox->is_idx) v2_json_idx_free(in_jbox); // Shared values go to index by next lookup
+
+    return(0);
+}
+/* =================================================================== */
+// Drop one owner of *p_ref, the last one frees it
+int v2_json_unref(json_ref_t **p_ref) {
+
+    if(!p_ref || !*p_ref) return(0);
+
+    if(!__atomic_sub_fetch(&(*p_ref)->cnt, 1, __ATOMIC_ACQ_REL)) {
+	v2_json_free_box(&(*p_ref)->box); // Shared subtrees it has are dropped too
+	free(*p_ref);
+    }
+    *p_ref=NULL;
+
+    return(0);
+}
+/* =================================================================== */
+// Container the next value of in_jbox goes to
+static json_lst_t *v2_json_parent(json_box_t *in_jbox) {
+    if(!in_jbox->tek) return(NULL);
+    if(in_jbox->tek->open==1) return(in_jbox->tek);
+    return(in_jbox->tek->parent);
+}
+/* =================================================================== */
+// Empty box to build next values of in_jbox container apart (other thread)
+// Values are moved back by v2_json_add_box(), out_sub is not allocated - v2_json_free_sub() frees values only
+int v2_json_sub(json_box_t *in_jbox, json_box_t *out_sub) {
+    json_lst_t *par=NULL;
+
+    if(!in_jbox || !out_sub)            return(17358);
+    if(!(par=v2_json_parent(in_jbox)))  return(17359); // Root values have no container
+
+    memset(out_sub, 0, sizeof(json_box_t));
+    out_sub->no_fullid=in_jbox->no_fullid;
+
+    if(!(out_sub->lst=(json_lst_t *)v2_json_alloc(out_sub, sizeof(json_lst_t)))) return(17350);
+    memset(out_sub->lst, 0, sizeof(json_lst_t));
+
+    out_sub->lst->js_type = par->js_type; // Stub of container
+    out_sub->lst->open    = 1;
+
+    out_sub->tek=out_sub->lst;
+
+    return(0);
+}
+/* =================================================================== */
+int v2_json_free_sub(json_box_t *in_sub) {
+
+    if(!in_sub) return(0);
+
+    v2_json_slab_free(&in_sub->slab);
+    v2_json_idx_free(in_sub);
+    v2_json_arr_free(in_sub, 0);
+    v2_json_tc_free(in_sub);
+    free(in_sub->keys);
+    while(in_sub->rcnt) v2_json_unref(&in_sub->refs[--in_sub->rcnt]);
+    free(in_sub->refs);
+    memset(in_sub, 0, sizeof(json_box_t));
+
+    return(0);
+}
+/* =================================================================== */
+// Move values of in_sub made by v2_json_sub() after the last value of in_jbox
+int v2_json_add_box(json_box_t *in_jbox, json_box_t *in_sub) {
+    json_slab_t *slab=NULL;
+    json_lst_t *par=NULL;
+    json_lst_t *last=NULL;
+    json_lst_t *node=NULL;
+    size_t x=0;
+    int rc=0;
+
+    if(!in_jbox || !in_sub || !in_sub->lst) return(17358);
+    if(!(par=v2_json_parent(in_jbox)))      return(17359);
+
+    v2_json_idx_free(in_jbox); // Made again by next lookup
+
+    for(x=0; x<in_sub->rcnt; x++) { // Shared subtrees - in_jbox owns them too, in_sub drops them
+	if((rc=v2_json_ref_keep(in_jbox, in_sub->refs[x]))) return(rc);
+    }
+
+    for(node=in_sub->lst->child; node; ) { // Ids go to in_jbox keys, shared ones are kept
+	if(!(node->id=v2_json_key(in_jbox, node->id, strlen(node->id)))) return(17350);
+
+	if(node->child && node->child->parent == node) {
+	    node=node->child;
+	    continue;
+	}
+	while(node && !node->next) node=(node->parent == in_sub->lst)?NULL:node->parent;
+	if(node) node=node->next;
+    }
+
+    if((last=in_sub->lst->child)) {
+	for(;; last=last->next) {
+	    last->parent=par;
+	    if(!last->next) break;
+	}
+
+	if(in_jbox->tek->open==1) {
+	    in_jbox->tek->open  = 0;
+	    in_jbox->tek->child = in_sub->lst->child;
+	} else {
+	    in_jbox->tek->next        = in_sub->lst->child;
+#ifndef V2_JSON_COMPACT
+	    in_jbox->tek->next->prev  = in_jbox->tek;
+#endif
+	}
+	in_jbox->tek=last;
+	v2_json_touch(in_jbox, par);
+
+	if(in_sub->chan) { // Named elements chain
+	    if(!in_jbox->chan) in_jbox->chan=in_sub->chan;
+#ifndef V2_JSON_COMPACT
+	    else               in_jbox->ctek->list=in_sub->chan;
+#endif
+	    in_jbox->ctek=in_sub->ctek;
+	}
+    }
+
+    if((slab=in_sub->slab)) { // Values memory goes with them
+	while(slab->next) slab=slab->next;
+	if(in_jbox->slab) {
+	    slab->next=in_jbox->slab->next;
+	    in_jbox->slab->next=in_sub->slab;
+	} else {
+	    in_jbox->slab=in_sub->slab;
+	}
+	in_sub->slab=NULL;
+    }
+
+    return(v2_json_free_sub(in_sub));
+}
+/* =================================================================== */
 // Any child object or array
 int v2_json_add_end(json_box_t *in_jbox, json_field js_type) {
 
@@ -236,7 +1207,10 @@ int v2_json_add_end(json_box_t *in_jbox, json_field js_type) {
 
     if(in_jbox->tek->open==1) { // Just close started parent
 	in_jbox->tek->open=0;
-	if(in_jbox->tek->js_type == JS_OBJECT) in_jbox->tek->js_type=JS_NULL; // Object can not be empty
+	if(in_jbox->tek->js_type == JS_OBJECT) { // Object can not be empty
+	    in_jbox->tek->js_type=JS_NULL;
+	    in_jbox->tek->open=2; // Was container - not in chain list
+	}
         return(0);
     }
 
@@ -292,17 +1266,27 @@ int v2_json_str(json_box_t *in_jbox, char *in_id, char *in_val) {
     int rc=0;
 
     if((rc=v2_json_add_node(in_jbox, in_id, JS_STRING))) return(rc);
-    v2_let_var(&in_jbox->tek->str, in_val);
+    in_jbox->tek->str=v2_json_strdup(in_jbox, in_val);
 
     return(0);
 }
 /* =================================================================== */
+// String value of in_len bytes is written by caller to returned buffer - no copy
+char *v2_json_str_new(json_box_t *in_jbox, char *in_id, size_t in_len) {
+
+    if(v2_json_add_node(in_jbox, in_id, JS_STRING)) return(NULL);
+    if(!(in_jbox->tek->str=(char *)v2_json_alloc(in_jbox, in_len+1))) return(NULL);
+    in_jbox->tek->str[0]='\0';
+
+    return(in_jbox->tek->str);
+}
+/* =================================================================== */
 int v2_json_bool(json_box_t *in_jbox, char *in_id, int is_true) {
     int rc=0;
 
     if((rc=v2_json_add_node(in_jbox, in_id, JS_BOOLEAN))) return(rc);
     if(is_true) in_jbox->tek->num=1;
-    v2_let_var(&in_jbox->tek->str, is_true?"true":"false");
+    V2_JSON_TEXT(in_jbox->tek, is_true?"true":"false"); // Constant strings, box does not free strings
 
     return(0);
 }
@@ -312,7 +1296,6 @@ int v2_json_int(json_box_t *in_jbox, char *in_id, int in_num) {
 
     if((rc=v2_json_add_node(in_jbox, in_id, JS_INT))) return(rc);
     in_jbox->tek->num=in_num;
-    in_jbox->tek->str=v2_string("%d", in_num);
 
     return(0);
 }
@@ -322,7 +1305,6 @@ int v2_json_lint(json_box_t *in_jbox, char *in_id, long long in_lnum) {
 
     if((rc=v2_json_add_node(in_jbox, in_id, JS_LONG))) return(rc);
     in_jbox->tek->lnum=in_lnum;
-    in_jbox->tek->str=v2_string("%lld", in_lnum);
 
     return(0);
 }
@@ -332,7 +1314,6 @@ int v2_json_double(json_box_t *in_jbox, char *in_id, double in_dnum) {
 
     if((rc=v2_json_add_node(in_jbox, in_id, JS_DOUBLE))) return(rc);
     in_jbox->tek->dnum=in_dnum;
-    in_jbox->tek->str=v2_string("%lld", in_dnum);
 
     return(0);
 }
@@ -341,7 +1322,90 @@ int v2_json_null(json_box_t *in_jbox, char *in_id) {
     int rc=0;
 
     if((rc=v2_json_add_node(in_jbox, in_id, JS_NULL))) return(rc);
-    v2_let_var(&in_jbox->tek->str, "null");
+    V2_JSON_TEXT(in_jbox->tek, "null");
+
+    return(0);
+}
+/* =================================================================== */
+// Change of built values
+/* =================================================================== */
+// in_json is changed (by hand) - containers it is in are printed again by next v2_json_text()
+int v2_json_touch(json_box_t *in_jbox, json_lst_t *in_json) {
+    json_txt_t *txt=NULL;
+
+    if(!in_jbox || !in_jbox->tc) return(0); // No text kept
+
+    for(; in_json; in_json=in_json->parent) {
+	if((txt=v2_json_txt_get(in_jbox->tc, in_json))) txt->dirty=1;
+    }
+    return(0);
+}
+/* =================================================================== */
+// Scalar in_json gets new type, value is set by caller
+static int v2_json_set(json_box_t *in_jbox, json_lst_t *in_json, json_field js_type) {
+
+    if(!in_jbox || !in_json)          return(17366);
+    if(in_json->shared)               return(17365); // Read only
+    if(v2_json_is_parent(in_json))    return(17366); // Scalars only
+
+    v2_json_touch(in_jbox, in_json);
+    in_json->js_type=js_type;
+    V2_JSON_TEXT(in_json, NULL); // Number text is made again by v2_json_value()
+
+    return(0);
+}
+/* =================================================================== */
+int v2_json_set_str(json_box_t *in_jbox, json_lst_t *in_json, char *in_val) {
+    int rc=0;
+
+    if((rc=v2_json_set(in_jbox, in_json, JS_STRING))) return(rc);
+    in_json->str=v2_json_strdup(in_jbox, in_val);
+
+    return(0);
+}
+/* =================================================================== */
+int v2_json_set_bool(json_box_t *in_jbox, json_lst_t *in_json, int is_true) {
+    int rc=0;
+
+    if((rc=v2_json_set(in_jbox, in_json, JS_BOOLEAN))) return(rc);
+    in_json->num=is_true?1:0;
+    V2_JSON_TEXT(in_json, is_true?"true":"false");
+
+    return(0);
+}
+/* =================================================================== */
+int v2_json_set_int(json_box_t *in_jbox, json_lst_t *in_json, int in_num) {
+    int rc=0;
+
+    if((rc=v2_json_set(in_jbox, in_json, JS_INT))) return(rc);
+    in_json->num=in_num;
+
+    return(0);
+}
+/* =================================================================== */
+int v2_json_set_lint(json_box_t *in_jbox, json_lst_t *in_json, long long in_lnum) {
+    int rc=0;
+
+    if((rc=v2_json_set(in_jbox, in_json, JS_LONG))) return(rc);
+    in_json->lnum=in_lnum;
+
+    return(0);
+}
+/* =================================================================== */
+int v2_json_set_double(json_box_t *in_jbox, json_lst_t *in_json, double in_dnum) {
+    int rc=0;
+
+    if((rc=v2_json_set(in_jbox, in_json, JS_DOUBLE))) return(rc);
+    in_json->dnum=in_dnum;
+
+    return(0);
+}
+/* =================================================================== */
+int v2_json_set_null(json_box_t *in_jbox, json_lst_t *in_json) {
+    int rc=0;
+
+    if((rc=v2_json_set(in_jbox, in_json, JS_NULL))) return(rc);
+    V2_JSON_TEXT(in_json, "null");
 
     return(0);
 }
@@ -385,7 +1449,7 @@ int v2_json_add_jobj(char *in_id, json_lst_t *in_json) {
 
     if(!in_json) {
 	if((rc=v2_json_add_node(&json_box, in_id, JS_NULL))) return(rc);
-	v2_let_var(&json_box.tek->str, "null");
+	V2_JSON_TEXT(json_box.tek, "null");
 	return(0);
     }
 
@@ -399,7 +1463,7 @@ int v2_json_add_str(char *in_id, char *in_val) {
     int rc=0;
 
     if((rc=v2_json_add_node(&json_box, in_id, JS_STRING))) return(rc);
-    v2_let_var(&json_box.tek->str, in_val);
+    json_box.tek->str=v2_json_strdup(&json_box, in_val);
 
     return(0);
 }
@@ -409,7 +1473,7 @@ int v2_json_add_bool(char *in_id, int is_true) {
 
     if((rc=v2_json_add_node(&json_box, in_id, JS_BOOLEAN))) return(rc);
     json_box.tek->num=is_true;
-    v2_let_var(&json_box.tek->str, is_true?"true":"false");
+    V2_JSON_TEXT(json_box.tek, is_true?"true":"false");
 
     return(0);
 }
@@ -419,7 +1483,6 @@ int v2_json_add_int(char *in_id, int in_num) {
 
     if((rc=v2_json_add_node(&json_box, in_id, JS_INT))) return(rc);
     json_box.tek->num=in_num;
-    json_box.tek->str=v2_string("%d", in_num);
 
     return(0);
 }
@@ -429,7 +1492,6 @@ int v2_json_add_lint(char *in_id, long long in_lnum) {
 
     if((rc=v2_json_add_node(&json_box, in_id, JS_LONG))) return(rc);
     json_box.tek->lnum=in_lnum;
-    json_box.tek->str=v2_string("%lld", in_lnum);
 
     return(0);
 }
@@ -439,7 +1501,6 @@ int v2_json_add_double(char *in_id, double in_dnum) {
 
     if((rc=v2_json_add_node(&json_box, in_id, JS_DOUBLE))) return(rc);
     json_box.tek->dnum=in_dnum;
-    json_box.tek->str=v2_string("%lld", in_dnum);
 
     return(0);
 }
@@ -448,7 +1509,7 @@ int v2_json_add_null(char *in_id) {
     int rc=0;
 
     if((rc=v2_json_add_node(&json_box, in_id, JS_NULL))) return(rc);
-    v2_let_var(&json_box.tek->str, "null");
+    V2_JSON_TEXT(json_box.tek, "null");
 
     return(0);
 }
@@ -468,146 +1529,277 @@ int v2_json_escape_quotas(char *out_str, size_t out_size, char *in_str) {
 /* =================================================================== */
 // Print functions
 /* =================================================================== */
-int v2_json_prn_field(json_box_t *in_jbox, json_lst_t *in_json) {
-    //json_lst_t *in_json=NULL;
-    char strout[MAX_STRING_LEN*6];
-    char strtmp[MAX_STRING_LEN*6];
-    char *coma="";
-    char *ends="";
-    //int x, y;
-
-    if(!in_jbox) return(0);
-    if(!in_json) return(0);
-
-    if(in_json->next) coma=",";
-    if(in_jbox->ident) ends="\n";
+// Comma if more values follow and new line if idented
+static void v2_json_prn_end(json_box_t *in_jbox, json_lst_t *in_json) {
 
-    if(in_json->js_type==JS_STRING) {
-	if(!in_json->str) {
-	    v2_wrbuf_printf(in_jbox->b, "\"\"%s%s", coma, ends);
-	    return(0);
+    if(in_json->next)   v2_wrbuf_putc(in_jbox->b, ',');
+    if(in_jbox->ident)  v2_wrbuf_putc(in_jbox->b, '\n');
+}
+/* =================================================================== */
+// Quoted string as set by no_escape, boxstr() and str() converters
+// Text is escaped right into output buffer room sized by its length - nothing is cut
+static int v2_json_prn_str(json_box_t *in_jbox, char *in_str, size_t in_len) {
+    char *out=NULL;
+    char *cnv=NULL; // Converted copy
+    char *tmp=NULL;
+    char *src=in_str;
+    int mode=V2_ESC_NONE;
+    size_t siz=0;
+
+    if(!in_jbox->no_escape)         mode=V2_ESC_UTF8;
+    else if(in_jbox->no_escape == 2) mode=V2_ESC_QUOTES; // Escape only quotas
+
+    if(in_jbox->boxstr == &v2_json_iconv && !in_jbox->str) { // Locale - iconv result is escaped itself, not copied back
+	if((cnv=v2_json_iconv_dup(in_jbox, in_str))) in_len=strlen(cnv);
+    } else if(in_jbox->boxstr || in_jbox->str) { // Converters change text in place - they get a copy with V2_JSON_CNV_ROOM()
+	siz=V2_JSON_CNV_ROOM(in_len);
+	if(!(cnv=(char*)malloc(siz))) return(17353);
+	memcpy(cnv, in_str, in_len);
+	cnv[in_len]='\0';
+	if(in_jbox->boxstr) { // new interface - need for local locale
+	    in_jbox->boxstr(in_jbox, cnv);
+	    in_len=strnlen(cnv, siz-1);
 	}
-
-	sprintf(strout, "%s", in_json->str);
-	if(in_jbox->boxstr) in_jbox->boxstr(in_jbox, strout); // new interface - need for local locale
-	if(in_jbox->str)    in_jbox->str(strout);             // for ex. koi -> utf8 old one
-
-	if(!in_jbox->no_escape) {
-	    u8_escape(strtmp, MAX_STRING_LEN*6-1, strout, 1);
-            sprintf(strout, "%s", strtmp);
-	} else if (in_jbox->no_escape == 2 ) { // Escape only quotas
-	    v2_json_escape_quotas(strtmp, MAX_STRING_LEN*6-1, strout);
-            sprintf(strout, "%s", strtmp);
+	if(in_jbox->str) { // for ex. koi -> utf8 old one - room by its own input
+	    if(V2_JSON_CNV_ROOM(in_len) > siz) {
+		if(!(tmp=(char*)realloc(cnv, V2_JSON_CNV_ROOM(in_len)))) {
+		    v2_freestr(&cnv);
+		    return(17353);
+		}
+		cnv=tmp;
+		siz=V2_JSON_CNV_ROOM(in_len);
+	    }
+	    in_jbox->str(cnv);
+	    in_len=strnlen(cnv, siz-1);
 	}
-	v2_wrbuf_printf(in_jbox->b, "\"%s\"%s%s", strout, coma, ends);
-        return(0);
     }
+    if(cnv) src=cnv;
 
-    if(in_json->js_type==JS_INT) {
-	v2_wrbuf_printf(in_jbox->b, "%d%s%s", in_json->num, coma, ends);
-        return(0);
-    }
+    v2_wrbuf_putc(in_jbox->b, '"');
 
-    if(in_json->js_type==JS_LONG) {
-	v2_wrbuf_printf(in_jbox->b, "%lld%s%s", in_json->lnum, coma, ends);
-        return(0);
+    if(mode == V2_ESC_NONE) { // As is
+	v2_wrbuf_putn(in_jbox->b, src, in_len);
+    } else if((out=v2_wrbuf_room(in_jbox->b, V2_ESC_SIZE(in_len)))) {
+	v2_wrbuf_used(in_jbox->b, v2_esc(out, src, in_len, mode));
     }
+    v2_freestr(&cnv);
 
-    if(in_json->js_type==JS_DOUBLE) {
-	v2_wrbuf_printf(in_jbox->b, "%g%s%s", in_json->dnum, coma, ends);
-        return(0);
-    }
-
-    if(in_json->js_type==JS_BOOLEAN) {
-	v2_wrbuf_printf(in_jbox->b, "%s%s%s", in_json->num?"true":"false", coma, ends);
-        return(0);
-    }
+    if(!out && mode != V2_ESC_NONE) return(17353);
+    v2_wrbuf_putc(in_jbox->b, '"');
+    return(0);
+}
+/* =================================================================== */
+int v2_json_prn_field(json_box_t *in_jbox, json_lst_t *in_json) {
+    char *out=NULL;
+    int rc=0;
 
+    if(!in_jbox) return(0);
+    if(!in_json) return(0);
 
-    // Object
-    if(in_json->js_type==JS_OBJECT) {
+    switch(in_json->js_type) {
+    case JS_STRING:
+	if(!in_json->str) {
+	    v2_wrbuf_putn(in_jbox->b, "\"\"", 2);
+	    break;
+	}
+	rc=v2_json_prn_str(in_jbox, in_json->str, strlen(in_json->str));
+	break;
+    case JS_INT:
+	v2_wrbuf_put_i64(in_jbox->b, in_json->num);
+	break;
+    case JS_LONG:
+	v2_wrbuf_put_i64(in_jbox->b, in_json->lnum);
+	break;
+    case JS_DOUBLE:
+	if((out=v2_wrbuf_room(in_jbox->b, V2_NUM_DTOA_LEN))) v2_wrbuf_used(in_jbox->b, v2_num_dtoa(in_json->dnum, out));
+	break;
+    case JS_BOOLEAN:
+	if(in_json->num) v2_wrbuf_putn(in_jbox->b, "true", 4);
+	else             v2_wrbuf_putn(in_jbox->b, "false", 5);
+	break;
+    case JS_OBJECT:
 	if(!in_json->child) {
-	    v2_wrbuf_printf(in_jbox->b, "null%s%s", coma, ends);
-	    return(0);
+	    v2_wrbuf_putn(in_jbox->b, "null", 4);
+	    break;
 	}
-	v2_wrbuf_printf(in_jbox->b, "{%s", ends);
+	v2_wrbuf_putc(in_jbox->b, '{');
+	if(in_jbox->ident) v2_wrbuf_putc(in_jbox->b, '\n');
 	v2_json_prnone(in_jbox, in_json->child);
-        if(in_jbox->spaces) v2_wrbuf_printf(in_jbox->b, "%*c", in_jbox->spaces, ' ');
-	v2_wrbuf_printf(in_jbox->b, "}%s%s", coma, ends);
-	return(0);
-    }
-
-    if(in_json->js_type==JS_ARRAY) {
+	v2_wrbuf_put_spaces(in_jbox->b, in_jbox->spaces);
+	v2_wrbuf_putc(in_jbox->b, '}');
+	break;
+    case JS_ARRAY:
 	if(!in_json->child) {
-	    //printf("null%s%s", in_coma, ends);
-	    v2_wrbuf_printf(in_jbox->b, "[]%s%s", coma, ends);
-	    return(0);
+	    v2_wrbuf_putn(in_jbox->b, "[]", 2);
+	    break;
 	}
-        v2_wrbuf_printf(in_jbox->b, "[%s", ends);
+	v2_wrbuf_putc(in_jbox->b, '[');
+	if(in_jbox->ident) v2_wrbuf_putc(in_jbox->b, '\n');
 	v2_json_prnone(in_jbox, in_json->child);
-	if(in_jbox->spaces) v2_wrbuf_printf(in_jbox->b, "%*c", in_jbox->spaces, ' ');
-	v2_wrbuf_printf(in_jbox->b, "]%s%s", coma, ends);
-	return(0);
+	v2_wrbuf_put_spaces(in_jbox->b, in_jbox->spaces);
+	v2_wrbuf_putc(in_jbox->b, ']');
+	break;
+    default: // Unsupported obj
+	v2_wrbuf_putn(in_jbox->b, "null", 4);
+	break;
     }
 
-    // Unsupported obj
-    v2_wrbuf_printf(in_jbox->b, "null%s%s", coma, ends);
-    return(0);
+    v2_json_prn_end(in_jbox, in_json);
+    return(rc);
 }
 /* =================================================================== */
 //int v2_json_prn_one(json_lst_t *in_json) {
-int v2_json_prnone(json_box_t *in_jbox, json_lst_t *in_json) {
-    char strout[MAX_STRING_LEN*6];
-    char strtmp[MAX_STRING_LEN*6];
-    json_lst_t *jsn_tmp=NULL;
-
-    if(!in_jbox) return(0);
+// Print in_json and its next ones with all children - open containers are kept on stack, no recursion
+// in_tc: clean containers are copied from last text, spans of printed ones are kept for next time
+static int v2_json_prn_list(json_box_t *in_jbox, json_lst_t *in_json, json_tc_t *in_tc) {
+    json_lst_t *jsn_tmp=in_json;
+    json_prn_t *stk=NULL;
+    json_prn_t *stk_tmp=NULL;
+    json_txt_t *txt=NULL;
+    size_t base=in_jbox->b->cnt; // Values start
+    size_t pnew=0; // Parent span start in new text
+    size_t pold=0; // and in last one
+    size_t dep=0;
+    size_t max=0;
+    int rc=0;
 
     in_jbox->spaces+=in_jbox->ident;
 
-    FOR_LST(jsn_tmp, in_json) {
-	if(jsn_tmp->js_type==JS_NONE) continue;
+    while(jsn_tmp && !rc) {
+	if(jsn_tmp->js_type!=JS_NONE) {
+	    v2_wrbuf_put_spaces(in_jbox->b, in_jbox->spaces);
 
-	if(in_jbox->spaces) v2_wrbuf_printf(in_jbox->b, "%*c", in_jbox->spaces, ' ');
+	    if(!(jsn_tmp->parent && (jsn_tmp->parent->js_type == JS_ARRAY))) {
 
-	if(!(jsn_tmp->parent && (jsn_tmp->parent->js_type == JS_ARRAY))) {
+		if((rc=v2_json_prn_str(in_jbox, jsn_tmp->id, strlen(jsn_tmp->id)))) break;
+		v2_wrbuf_putn(in_jbox->b, ": ", 2);
+	    }
 
-	    //sprintf(strout, "%s", jsn_tmp->id);
-	    strncpy(strout, jsn_tmp->id, MAX_STRING_LEN*2);
-	    if(in_jbox->boxstr) in_jbox->boxstr(in_jbox, strout);
-	    if(in_jbox->str)    in_jbox->str(strout);
+	    if((jsn_tmp->js_type==JS_OBJECT || jsn_tmp->js_type==JS_ARRAY) && jsn_tmp->child) {
+		txt=NULL;
+		pold=(size_t)-1;
+		if(in_tc) {
+		    pnew=dep?stk[dep-1].nabs:base;
+		    pold=dep?stk[dep-1].oabs:in_tc->base;
+		    if(pold != (size_t)-1 && !(txt=v2_json_txt_get(in_tc, jsn_tmp))) pold=(size_t)-1;
+		}
+
+		if(txt && !txt->dirty && txt->spaces == in_jbox->spaces && pold+txt->off+txt->len <= in_tc->tb.cnt) { // Clean - copy it
+		    v2_wrbuf_write(in_jbox->b, in_tc->tb.buf+pold+txt->off, 1, txt->len);
+		    txt->off=in_jbox->b->cnt-txt->len-pnew;
+		    v2_json_prn_end(in_jbox, jsn_tmp);
+		} else { // Go down
+		    if(dep == max) {
+			if(!(stk_tmp=(json_prn_t *)realloc(stk, (max?max*2:64)*sizeof(json_prn_t)))) {
+			    rc=17353;
+			    break;
+			}
+			stk=stk_tmp;
+			max=max?max*2:64;
+		    }
+		    stk[dep].json=jsn_tmp;
+		    stk[dep].nabs=in_jbox->b->cnt;
+		    stk[dep].oabs=txt?pold+txt->off:(size_t)-1;
+		    dep++;
+
+		    v2_wrbuf_putc(in_jbox->b, jsn_tmp->js_type==JS_OBJECT?'{':'[');
+		    if(in_jbox->ident) v2_wrbuf_putc(in_jbox->b, '\n');
+		    in_jbox->spaces+=in_jbox->ident;
+		    jsn_tmp=jsn_tmp->child;
+		    continue;
+		}
+	    } else {
+		rc=v2_json_prn_field(in_jbox, jsn_tmp);
+	    }
+	}
 
-	    if(!in_jbox->no_escape) {
-		u8_escape(strtmp, MAX_STRING_LEN*6, strout, 1);
-		sprintf(strout, "%s", strtmp);
-	    } else if (in_jbox->no_escape == 2 ) { // Escape only quotas
-		v2_json_escape_quotas(strtmp, MAX_STRING_LEN*6-1, strout);
-		sprintf(strout, "%s", strtmp);
+	// Go up from last children - close their parents
+	while(!jsn_tmp->next && dep) {
+	    jsn_tmp=stk[--dep].json;
+	    in_jbox->spaces-=in_jbox->ident;
+	    v2_wrbuf_put_spaces(in_jbox->b, in_jbox->spaces);
+	    v2_wrbuf_putc(in_jbox->b, jsn_tmp->js_type==JS_OBJECT?'}':']');
+
+	    if(in_tc && !in_tc->bad) { // Span of printed container
+		if((txt=v2_json_txt_set(in_tc, jsn_tmp))) {
+		    txt->off    = stk[dep].nabs-(dep?stk[dep-1].nabs:base);
+		    txt->len    = in_jbox->b->cnt-stk[dep].nabs;
+		    txt->spaces = in_jbox->spaces;
+		    txt->dirty  = 0;
+		} else {
+		    in_tc->bad=1;
+		}
 	    }
-	    v2_wrbuf_printf(in_jbox->b, "\"%s\": ", strout);
+	    v2_json_prn_end(in_jbox, jsn_tmp);
 	}
-	v2_json_prn_field(in_jbox, jsn_tmp);
+	jsn_tmp=jsn_tmp->next;
     }
 
-    in_jbox->spaces-=in_jbox->ident;
+    in_jbox->spaces-=in_jbox->ident*(dep+1);
+    free(stk);
 
-    return(0);
+    if(in_tc) in_tc->base=base;
+
+    return(rc);
 }
 /* =================================================================== */
-// Move structure to output buffer
-int v2_json_text(json_box_t *in_jbox) {
-    str_lst_t *str_tmp=NULL;
-    int is_alloc=0;
-    int rc=0;
+int v2_json_prnone(json_box_t *in_jbox, json_lst_t *in_json) {
 
-    if(!in_jbox) return(17391); // Nothin to do....
+    if(!in_jbox) return(0);
 
-    if(!in_jbox->b) is_alloc=1;
+    return(v2_json_prn_list(in_jbox, in_json, NULL));
+}
+/* =================================================================== */
+// Last text to copy clean containers from: output buffer is taken back if it is not changed since
+static json_tc_t *v2_json_tc_take(json_box_t *in_jbox) {
+    json_tc_t *tc=in_jbox->tc;
 
-    if(is_alloc || !in_jbox->no_clean) {
-	if((rc=v2_wrbuf_new(&in_jbox->b))) return(rc);
+    if(!tc) {
+	if(!(tc=(json_tc_t *)calloc(1, sizeof(json_tc_t)))) return(NULL);
+	in_jbox->tc=tc;
+    }
+
+    if(in_jbox->b && in_jbox->b->buf && in_jbox->b->buf == tc->tbuf && in_jbox->b->cnt == tc->tlen) {
+	v2_wrbuf_reset(&tc->tb);
+	tc->tb=*in_jbox->b;
+	v2_wrbuf_init(in_jbox->b);
+    }
+
+    if(!tc->tb.buf || tc->tb.buf != tc->tbuf
+       || tc->prn       != (in_jbox->prn?in_jbox->prn:in_jbox->lst)
+       || tc->ident     != in_jbox->ident
+       || tc->no_escape != in_jbox->no_escape
+       || tc->boxstr    != in_jbox->boxstr
+       || tc->str       != in_jbox->str) { // No last text or other settings - print all
+	v2_json_txt_clean(tc);
     }
 
+    return(tc);
+}
+/* =================================================================== */
+// New text is kept for next v2_json_text()
+static int v2_json_tc_keep(json_box_t *in_jbox, json_tc_t *in_tc, wrbuf_t *in_text, int in_ok) {
+
+    v2_wrbuf_reset(&in_tc->tb); // Last text is not needed more
+    if(!in_ok || in_tc->bad) v2_json_txt_clean(in_tc);
+
+    in_tc->prn       = in_jbox->prn;
+    in_tc->ident     = in_jbox->ident;
+    in_tc->no_escape = in_jbox->no_escape;
+    in_tc->boxstr    = in_jbox->boxstr;
+    in_tc->str       = in_jbox->str;
+
+    in_tc->tbuf = in_text->buf;
+    in_tc->tlen = in_text->cnt;
+
+    return(0);
+}
+/* =================================================================== */
+// Header and json to in_jbox->b
+static int v2_json_text_put(json_box_t *in_jbox, json_tc_t *in_tc) {
+    str_lst_t *str_tmp=NULL;
+    int rc=0;
+
     if(in_jbox->header) {
 	v2_wrbuf_printf(in_jbox->b, "Content-Type: application/json; charset=\"utf-8\"\n");
 	FOR_LST(str_tmp, in_jbox->hdr) v2_wrbuf_printf(in_jbox->b, "%s%s%s\n", str_tmp->key, str_tmp->str?": ":"", v2_nn(str_tmp->str));
@@ -620,24 +1812,76 @@ int v2_json_text(json_box_t *in_jbox) {
     if(!in_jbox->prn) in_jbox->prn=in_jbox->lst;
 
     if(!in_jbox->prn) {
-	v2_wrbuf_printf(in_jbox->b, "[]\n"); // Empty list.
+	v2_wrbuf_putn(in_jbox->b, "[]\n", 3); // Empty list.
     } else {
 
 	if((v2_json_type(in_jbox->prn) == JS_ARRAY) && !v2_strcmp(in_jbox->prn->id, "_")) { // Special case core arr "_" : [el, el, ]
-	    v2_wrbuf_printf(in_jbox->b, "[%s", in_jbox->ident?"\n":"");
-	    rc=v2_json_prnone(in_jbox, in_jbox->prn->child);
-	    v2_wrbuf_printf(in_jbox->b, "]\n");
+	    v2_wrbuf_puts(in_jbox->b, in_jbox->ident?"[\n":"[");
+	    rc=v2_json_prn_list(in_jbox, in_jbox->prn->child, in_tc);
+	    v2_wrbuf_putn(in_jbox->b, "]\n", 2);
 	} else {
-	    v2_wrbuf_printf(in_jbox->b, "{%s", in_jbox->ident?"\n":"");
-	    rc=v2_json_prnone(in_jbox, in_jbox->prn);
-	    v2_wrbuf_printf(in_jbox->b, "}\n");
+	    v2_wrbuf_puts(in_jbox->b, in_jbox->ident?"{\n":"{");
+	    rc=v2_json_prn_list(in_jbox, in_jbox->prn, in_tc);
+	    v2_wrbuf_putn(in_jbox->b, "}\n", 2);
 	}
+    }
+    return(rc);
+}
+/* =================================================================== */
+// Print through in_out sink - text is not kept, in_jbox->b is not touched. Caller frees in_out
+static int v2_json_stream(json_box_t *in_jbox, wrbuf_t *in_out) {
+    wrbuf_t *b=in_jbox->b;
+    int rc=0;
+
+    in_jbox->b=in_out;
+    rc=v2_json_text_put(in_jbox, NULL);
+    if(v2_wrbuf_flush(in_out)) rc=17380; // Sink failed - no room errors come from it too
+    in_jbox->b=b;
+
+    in_jbox->prn=NULL; // Reset print pointer
+
+    return(rc);
+}
+/* =================================================================== */
+// Move structure to output buffer
+int v2_json_text(json_box_t *in_jbox) {
+    json_tc_t *tc=NULL;
+    wrbuf_t out;
+    int is_alloc=0;
+    int rc=0;
+
+    if(!in_jbox) return(17391); // Nothin to do....
+
+    if(!in_jbox->b) is_alloc=1;
 
-        if(rc) return(rc);
+    if(is_alloc && !in_jbox->keep_text) { // Local printing - by parts, no full text
+	v2_json_tc_free(in_jbox);
+	v2_wrbuf_init(&out);
+	v2_wrbuf_sink_file(&out, stdout, 0);
+	rc=v2_json_stream(in_jbox, &out);
+	v2_wrbuf_reset(&out);
+	return(rc);
     }
+
+    if(in_jbox->keep_text && (is_alloc || !in_jbox->no_clean)) tc=v2_json_tc_take(in_jbox); // Text is not added to other one
+    else                                                       v2_json_tc_free(in_jbox);
+
+    if(is_alloc || !in_jbox->no_clean) {
+	if((rc=v2_wrbuf_new(&in_jbox->b))) return(rc);
+    }
+
+    rc=v2_json_text_put(in_jbox, tc);
+
+    if(tc) v2_json_tc_keep(in_jbox, tc, in_jbox->b, !rc && in_jbox->prn);
+    if(rc) return(rc);
+
     // Print if asked
     if(is_alloc) {
-	if(in_jbox->b->buf) printf("%s", in_jbox->b->buf); // Local printing
+	if(in_jbox->b->buf) fwrite(in_jbox->b->buf, 1, in_jbox->b->cnt, stdout); // Local printing
+	if(tc) { // Text is kept, not freed
+	    tc->tb=*in_jbox->b;
+	    v2_wrbuf_init(in_jbox->b);
+	}
 	v2_wrbuf_free(&in_jbox->b);
     }
 
@@ -646,6 +1890,80 @@ int v2_json_text(json_box_t *in_jbox) {
     return(rc);
 }
 /* =================================================================== */
+// Streaming print - text goes out by in_flush bytes (0 - V2_WRBUF_BLOCK) as it is made, in_jbox->b is not used
+int v2_json_write(json_box_t *in_jbox, int in_fd, size_t in_flush) {
+    wrbuf_t out;
+    int rc=0;
+
+    if(!in_jbox) return(17391);
+
+    v2_wrbuf_init(&out);
+    if(v2_wrbuf_sink_fd(&out, in_fd, in_flush)) return(17363);
+
+    rc=v2_json_stream(in_jbox, &out);
+    v2_wrbuf_reset(&out);
+
+    return(rc);
+}
+/* =================================================================== */
+int v2_json_fwrite(json_box_t *in_jbox, FILE *in_file, size_t in_flush) {
+    wrbuf_t out;
+    int rc=0;
+
+    if(!in_jbox) return(17391);
+
+    v2_wrbuf_init(&out);
+    if(v2_wrbuf_sink_file(&out, in_file, in_flush)) return(17363);
+
+    rc=v2_json_stream(in_jbox, &out);
+    v2_wrbuf_reset(&out);
+
+    return(rc);
+}
+/* =================================================================== */
+int v2_json_sink(json_box_t *in_jbox, size_t (*in_sink)(void *, const char *, size_t), void *in_data, size_t in_flush) {
+    wrbuf_t out;
+    int rc=0;
+
+    if(!in_jbox) return(17391);
+    if(!in_sink) return(17363);
+
+    v2_wrbuf_init(&out);
+    v2_wrbuf_sink(&out, in_sink, in_data, in_flush);
+
+    rc=v2_json_stream(in_jbox, &out);
+    v2_wrbuf_reset(&out);
+
+    return(rc);
+}
+/* =================================================================== */
+// File is written to temporary one and renamed when all is there
+static int v2_json_save_box(json_box_t *in_jbox, char *in_file) {
+    char t_name[MAX_STRING_LEN+40];
+    wrbuf_t out;
+    size_t size=0;
+    int fd=-1;
+    int rc=0;
+
+    snprintf(t_name, sizeof(t_name), "%s.tmp_%d", in_file, (int)getpid());
+
+    if((fd=open(t_name, O_WRONLY|O_CREAT|O_TRUNC, 0666)) < 0) return(17381);
+
+    v2_wrbuf_init(&out);
+    v2_wrbuf_sink_fd(&out, fd, 0);
+    rc=v2_json_stream(in_jbox, &out);
+    size=out.sout;
+    v2_wrbuf_reset(&out);
+
+    if(close(fd) && !rc) rc=17382;
+    if(rc) {
+	unlink(t_name);
+	return(rc);
+    }
+
+    return(v2_vop_rename(size, t_name, in_file));
+}
+/* =================================================================== */
 int v2_json_print(void) {
     int rc=0;
 
@@ -679,15 +1997,10 @@ char *v2_json_out(json_lst_t *in_json) {
 // Write file
 int v2_json_save(char *fname, ...) {
     char strfil[MAX_STRING_LEN];
-    int rc=0;
 
     VL_STR(strfil, MAX_STRING_LEN, fname);
 
-    if((rc=v2_wrbuf_new(&json_box.b)))               return(rc); // Create or clean buffer
-    if((rc=v2_json_text(&json_box)))                 return(rc);
-    if((rc=v2_wrbuf_save(json_box.b, "%s", strfil))) return(rc);
-    //v2_wrbuf_reset(v2_jsmn.box->b); // Does it need here? - Looks like not.
-    return(0);
+    return(v2_json_save_box(&json_box, strfil));
 }
 /* =================================================================== */
 int v2_json_store(json_lst_t *in_json, int is_esc,  char *fname, ...) {
@@ -706,10 +2019,9 @@ int v2_json_store(json_lst_t *in_json, int is_esc,  char *fname, ...) {
 
     jbox->lst = in_json;
 
-    if(v2_wrbuf_new(&jbox->b)) return(17377);
-    if(v2_json_text(jbox)) return(17378);
-    if((rc=v2_wrbuf_save(jbox->b, "%s", file_name))) return(v2_ret_error(17379, "Can not save file[rc=%d]: %s", rc, file_name));
-    v2_wrbuf_free(&jbox->b);
+    rc=v2_json_save_box(jbox, file_name);
+    free(jbox); // Nothing to clear - json list external (!!!)
+    if(rc) return(v2_ret_error(17379, "Can not save file[rc=%d]: %s", rc, file_name));
 
     return(0);
 }
@@ -718,6 +2030,8 @@ int v2_json_store(json_lst_t *in_json, int is_esc,  char *fname, ...) {
 int v2_json_debug(int level, json_lst_t *in_json, char *in_msg, ...) {
     json_lst_t *json_tmp=NULL;
     char strtmp[MAX_STRING_LEN];
+    char full_id[MAX_STRING_LEN];
+    char val[MAX_STRING_LEN];
 
     VL_STR(strtmp, MAX_STRING_LEN, in_msg);
 
@@ -726,7 +2040,8 @@ int v2_json_debug(int level, json_lst_t *in_json, char *in_msg, ...) {
 	return(0);
     }
 
-    v2_add_debug(level, "%s: %s \"%s\" = \"%s\"", strtmp, v2_json_type_str(in_json), in_json->full_id, v2_nn(in_json->str));
+    v2_json_path(in_json, full_id, sizeof(full_id));
+    v2_add_debug(level, "%s: %s \"%s\" = \"%s\"", strtmp, v2_json_type_str(in_json), full_id, v2_json_scalar(in_json, val, sizeof(val)));
 
     if((v2_json_type(in_json)==JS_OBJECT) || (v2_json_type(in_json)==JS_ARRAY)) {
 	FOR_LST(json_tmp, in_json->child) v2_json_debug(level, json_tmp, in_msg);
@@ -35,6 +35,33 @@ typedef enum {
     JS_NULL
 } json_field;
 
+#ifdef V2_JSON_COMPACT
+// Compact node - 48 bytes: one value by type, no prev, list, array and full_id links
+// Use V2_JSON_*() macros below to get them in any build
+typedef struct _json_lst_t {
+    struct _json_lst_t *next;
+    struct _json_lst_t *child;
+    struct _json_lst_t *parent;
+
+    char *id;
+
+    union {
+	char *str;      // JS_STRING
+	int num;        // JS_INT, JS_BOOLEAN
+	long long lnum; // JS_LONG
+	double dnum;    // JS_DOUBLE
+    };
+
+    unsigned char js_type; // json_field
+    unsigned char open;    // Marks open array or object
+    unsigned char shared;  // 1 = read only node of shared subtree (v2_json_ref()), 2 = its root
+} json_lst_t;
+
+#define V2_JSON_STR(j)       ((j)->js_type == JS_STRING ? (j)->str : NULL)
+#define V2_JSON_PREV(b, j)   v2_json_prev((b), (j))
+#define V2_JSON_LIST(j)      v2_json_list(j)
+#define V2_JSON_FID(j)       ((char *)NULL) // Kept by box - v2_json_full_id()
+#else
 typedef struct _json_lst_t {
     struct _json_lst_t *next;
     struct _json_lst_t *prev;
@@ -49,7 +76,7 @@ typedef struct _json_lst_t {
     json_field js_type;
 
     char *id;
-    char *full_id; // Full ID like "group.admin.name.first"
+    char *full_id; // Full ID like "group.admin.name.first" - NULL until v2_json_full_id() makes it
     char *str;
 
     int num;
@@ -59,8 +86,29 @@ typedef struct _json_lst_t {
     //int bl; // Boolean 0=none, 1=true, 2=false - depricated - remove it and use "num" instead
 
     int open; // Marks open array or object
+    int shared; // 1 = read only node of shared subtree (v2_json_ref()), 2 = its root
 } json_lst_t;
 
+#define V2_JSON_STR(j)       ((j)->str)
+#define V2_JSON_PREV(b, j)   ((j)->prev)
+#define V2_JSON_LIST(j)      ((j)->list)
+#define V2_JSON_FID(j)       ((j)->full_id)
+#endif
+
+
+// Box memory block
+#define V2_JSON_SLAB 65536
+
+typedef struct json_slab_s {
+    struct json_slab_s *next;
+    size_t siz; // Size of data
+    size_t cnt; // Used bytes
+    char data[];
+} json_slab_t;
+
+// Converters boxstr() and str() change string of in_len bytes in place, it has V2_JSON_CNV_ROOM(in_len) bytes
+// with '\0' to grow: 6 bytes per byte (+1), not less than MAX_STRING_LEN*6 for short ones
+#define V2_JSON_CNV_ROOM(in_len) ((in_len) < MAX_STRING_LEN ? MAX_STRING_LEN*6 : ((in_len)+1)*6)
 
 typedef struct json_box_s {
     json_lst_t *lst; // Root of json structure
@@ -75,25 +123,70 @@ typedef struct json_box_s {
     int ident;     // Ident - number of spaces - good choice - 4 - set 0 to one strings output
     int header;    // 1 = add Content-Type header
     int no_escape; // 1 = do not escape UTF8 symbols (visual output), 2 = escape only quotas (raw UTF mode)
-    int no_fullid; // 1 = Do not make full ID and chain list
+    int no_fullid; // 1 = Do not make chain list
     int no_clean;  // 1 = Do not clean output buff - just add text
+    int keep_text; // 1 = v2_json_text() keeps text, next one copies containers not changed since (see v2_json_touch())
 
     int arr_no; // Array element number
 
+    // Arena - all nodes and their strings, freed by v2_json_free_box() at once
+    json_slab_t *slab;  // Current slab, others are linked by next
+    json_slab_t *spare; // Empty slabs for next values
+    int reuse;          // 1 = v2_json_free_box() keeps slabs to spare (v2_json_new() on the same box)
+
+    // Interned ids - nodes with the same id share one string
+    char **keys; // Open addressing table of kmax (power of 2) slots
+    size_t kmax;
+    size_t kcnt;
+
+    // Lookup index - nodes by parent and id, made by first v2_json_find() or v2_json_child()
+    json_lst_t **idx; // Open addressing table of imax (power of 2) slots
+    size_t imax;
+    size_t icnt;
+    int is_idx;       // 1 = all nodes are in idx
+
+    // Element vectors of containers used by v2_json_at()
+    struct json_arr_s *arr; // Open addressing table of amax (power of 2) slots
+    size_t amax;
+    size_t acnt;
+
+#ifdef V2_JSON_COMPACT
+    // Full IDs made by v2_json_full_id() - nodes have no room for them
+    struct json_fid_s *fid; // Open addressing table of fmax (power of 2) slots
+    size_t fmax;
+    size_t fcnt;
+#endif
+
+    // Last text of v2_json_text() with spans of containers - made if keep_text is set
+    struct json_tc_s *tc;
+
+    // Shared subtrees added by v2_json_jref() - released with box
+    struct json_ref_s **refs;
+    size_t rmax;
+    size_t rcnt;
+
     str_lst_t *hdr;  // Extra headers line if ->header != 0
 
     // New interface for external box
     char *locale;   // Set local locale
-    int (*boxstr)(struct json_box_s*, char *); // Operate by string - ex. locale to UTF (Send) or UTF to locale (Receive)
+    int (*boxstr)(struct json_box_s*, char *); // Operate by string - ex. locale to UTF (Send) or UTF to locale (Receive), see V2_JSON_CNV_ROOM()
     int is_delocale; // Have to delocale it UTF -> locale
 
     // Easy way for default box
-    int (*str)(char *); // Operate by string - ex. utf to locale
+    int (*str)(char *); // Operate by string - ex. utf to locale, see V2_JSON_CNV_ROOM()
 
     // Internal use
     int spaces;
 } json_box_t; // Box with all json things
 
+// Shared subtree: values of box made read only by v2_json_ref(), put to other boxes by v2_json_jref() with no copy
+// Freed by the last owner - v2_json_unref() of its maker or v2_json_free_box() of box it was put to
+typedef struct json_ref_s {
+    json_lst_t *json; // Root - object with box values
+    json_box_t box;   // Values memory
+    int cnt;          // Owners
+} json_ref_t;
+
 
 extern json_box_t json_box; // Default box
 
@@ -111,7 +204,52 @@ int v2_json_new(json_box_t **p_box);
 int v2_json_free_box(json_box_t *in_jbox);
 int v2_json_add_node(json_box_t *in_jbox, char *in_id, json_field js_type);
 int v2_json_add_end(json_box_t *in_jbox, json_field js_type);
-int v2_json_text(json_box_t *in_jbox);
+int v2_json_text(json_box_t *in_jbox); // To in_jbox->b, b == NULL - to stdout by parts
+
+// Lookup by hash index
+json_lst_t *v2_json_find(json_box_t *in_jbox, char *in_path); // By full ID like "part1.portion1.word1"
+json_lst_t *v2_json_child(json_box_t *in_jbox, json_lst_t *in_json, char *in_id); // Member of in_json, NULL - root value
+json_lst_t *v2_json_at(json_box_t *in_jbox, json_lst_t *in_json, size_t in_idx); // Element of array, O(1)
+size_t v2_json_len(json_box_t *in_jbox, json_lst_t *in_json); // Number of elements
+
+// Scalar value as text - number nodes keep binary value only
+char *v2_json_scalar(json_lst_t *in_json, char *out_str, size_t out_size); // To out_str
+char *v2_json_value(json_box_t *in_jbox, json_lst_t *in_json); // Numbers are formatted once, to box memory
+
+// Links compact nodes do not keep - found by walk
+json_lst_t *v2_json_prev(json_box_t *in_jbox, json_lst_t *in_json); // Previous one of the same parent
+json_lst_t *v2_json_list(json_lst_t *in_json); // Next scalar in text order - chain list from json_box.chan
+
+// Full ID like "group.admin.name.first" by parent links
+char *v2_json_full_id(json_box_t *in_jbox, json_lst_t *in_json); // Made once and kept in node
+size_t v2_json_path(json_lst_t *in_json, char *out_str, size_t out_size); // Not kept, returns length
+
+// Box memory: freed with box only - do not free() or realloc() node id, str and full_id
+void *v2_json_alloc(json_box_t *in_jbox, size_t in_size);
+char *v2_json_strdup(json_box_t *in_jbox, const char *in_str);
+char *v2_json_strndup(json_box_t *in_jbox, const char *in_str, size_t in_len);
+char *v2_json_key(json_box_t *in_jbox, const char *in_id, size_t in_len); // Interned id - compare node ids by pointer
+
+// Build part of container apart (ex. by other thread) and join it
+int v2_json_sub(json_box_t *in_jbox, json_box_t *out_sub); // out_sub gets next values of in_jbox current container
+int v2_json_add_box(json_box_t *in_jbox, json_box_t *in_sub); // Move in_sub values to in_jbox, in order
+int v2_json_free_sub(json_box_t *in_sub);
+
+// Shared read only subtrees - one copy for many boxes (and threads)
+// Full ID of shared node starts at its subtree, chain list (json_box.chan) does not go into them
+int v2_json_ref(json_box_t *in_jbox, json_ref_t **p_ref); // Values of in_jbox to new shared subtree, in_jbox gets empty
+int v2_json_jref(json_box_t *in_jbox, char *in_id, json_ref_t *in_ref); // Add it as object in_id - O(1), closed already
+int v2_json_unref(json_ref_t **p_ref); // Drop one owner
+
+// Change values of built box - with keep_text only changed containers are printed again
+// Values changed by hand (not by v2_json_set_*()) need v2_json_touch() before next v2_json_text()
+int v2_json_touch(json_box_t *in_jbox, json_lst_t *in_json); // in_json is changed - its containers are not clean
+int v2_json_set_str(json_box_t *in_jbox, json_lst_t *in_json, char *in_val);
+int v2_json_set_bool(json_box_t *in_jbox, json_lst_t *in_json, int is_true);
+int v2_json_set_int(json_box_t *in_jbox, json_lst_t *in_json, int in_num);
+int v2_json_set_lint(json_box_t *in_jbox, json_lst_t *in_json, long long in_lnum);
+int v2_json_set_double(json_box_t *in_jbox, json_lst_t *in_json, double in_dnum);
+int v2_json_set_null(json_box_t *in_jbox, json_lst_t *in_json);
 
 // -----------------------------------------------------------------------------------------
 int v2_json_locale(json_box_t *in_jbox, char *in_locale, int is_de); // Set locale (or de_locale) and assign iconv function
@@ -150,6 +288,7 @@ int v2_json_arr(json_box_t *in_jbox, char *in_id);
 int v2_json_obj(json_box_t *in_jbox, char *in_id);
 
 int v2_json_str(json_box_t *in_jbox, char *in_id, char *in_val);
+char *v2_json_str_new(json_box_t *in_jbox, char *in_id, size_t in_len); // Returns place for in_len bytes string value
 int v2_json_bool(json_box_t *in_jbox, char *in_id, int is_true);
 int v2_json_int(json_box_t *in_jbox, char *in_id, int in_num);
 int v2_json_lint(json_box_t *in_jbox, char *in_id, long long in_lnum);
@@ -164,6 +303,12 @@ int v2_json_print(void);            // Print json list
 
 char *v2_json_out(json_lst_t *in_json); // Returns pointer to allocated buffer with text of json
 
+// Streaming print - text goes out by in_flush bytes (0 - V2_WRBUF_BLOCK) while it is made, no full text in memory
+// Returns 17380 if sink failed. keep_text is not used - see v2_json_text()
+int v2_json_write(json_box_t *in_jbox, int in_fd, size_t in_flush);         // write()/writev() to in_fd
+int v2_json_fwrite(json_box_t *in_jbox, FILE *in_file, size_t in_flush);   // fwrite() to in_file
+int v2_json_sink(json_box_t *in_jbox, size_t (*in_sink)(void *, const char *, size_t), void *in_data, size_t in_flush);
+
 int v2_json_save(char *fname, ...); // Write json_box to a file
 int v2_json_store(json_lst_t *in_json, int is_esc,  char *fname, ...); // Write json list to file
 
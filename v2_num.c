@@ -0,0 +1,452 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h> // signbit
+
+#include "v2_num.h"
+
+// Exact doubles - 10^22 is the last one
+static const double vn_pow10[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* ========================================================================= */
+// Slow and exact way
+static double vn_strtod(const char *in_str, size_t in_len) {
+    char buf[64];
+    char *str=buf;
+    double out=0;
+
+    if(in_len >= sizeof(buf)) {
+	if(!(str=(char *)malloc(in_len+1))) return(0);
+    }
+    memcpy(str, in_str, in_len);
+    str[in_len]='\0';
+
+    out=strtod(str, NULL);
+
+    if(str != buf) free(str);
+    return(out);
+}
+/* ========================================================================= */
+int v2_num_parse(const char *in_str, size_t in_len, long long *p_lnum, double *p_dnum) {
+    const char *p=in_str;
+    const char *end=in_str+in_len;
+    uint64_t mant=0; // First 19 significant digits
+    long exp10=0;    // Decimal exponent of mant
+    long exp=0;      // After 'e'
+    int sig=0;       // Significant digits in mant
+    int lost=0;      // Non zero digits did not go to mant
+    int digits=0;    // All mantissa digits
+    int is_neg=0;
+    int is_exp_neg=0;
+    int is_dbl=0;
+    double out=0;
+
+    if(p < end && *p == '-') {
+	is_neg=1;
+	p++;
+    }
+
+    for(; p < end && *p >= '0' && *p <= '9'; p++, digits++) { // Integer part
+	if(sig < 19) {
+	    mant=mant*10+(*p-'0');
+	    if(mant) sig++;
+	} else {
+	    exp10++;
+	    if(*p != '0') lost=1;
+	}
+    }
+
+    if(p < end && *p == '.') { // Fraction
+	is_dbl=1;
+	for(p++; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+	    if(sig < 19) {
+		mant=mant*10+(*p-'0');
+		if(mant) sig++;
+		exp10--;
+	    } else {
+		if(*p != '0') lost=1;
+	    }
+	}
+    }
+
+    if(!digits) return(V2_NUM_NONE);
+
+    if(p < end && (*p == 'e' || *p == 'E')) { // Exponent
+	is_dbl=1;
+	p++;
+	if(p < end && (*p == '-' || *p == '+')) is_exp_neg=(*p++ == '-');
+	if(p >= end || *p < '0' || *p > '9') return(V2_NUM_NONE);
+	for(; p < end && *p >= '0' && *p <= '9'; p++) {
+	    if(exp < 100000) exp=exp*10+(*p-'0'); // Far out of double range anyway
+	}
+	exp10 += is_exp_neg?-exp:exp;
+    }
+
+    if(p != end) return(V2_NUM_NONE);
+
+    if(!is_dbl && !exp10) { // Integer - exp10 != 0 means more than 19 digits
+	if(!is_neg && mant <= (uint64_t)INT64_MAX) {
+	    *p_lnum=(long long)mant;
+	    return(V2_NUM_LONG);
+	}
+	if(is_neg && mant <= (uint64_t)INT64_MAX+1) {
+	    *p_lnum=(long long)(0-mant);
+	    return(V2_NUM_LONG);
+	}
+    }
+
+    if(!mant && !lost) { // Zero of any exponent
+	*p_dnum=is_neg?-0.0:0.0;
+	return(V2_NUM_DOUBLE);
+    }
+
+    if(!lost && mant <= (1ULL<<53) && exp10 >= -22 && exp10 <= 22) { // Both exact - one rounding only
+	out=(double)mant;
+	if(exp10 < 0) out/=vn_pow10[-exp10];
+	else          out*=vn_pow10[exp10];
+	*p_dnum=is_neg?-out:out;
+	return(V2_NUM_DOUBLE);
+    }
+
+    *p_dnum=vn_strtod(in_str, in_len);
+    return(V2_NUM_DOUBLE);
+}
+/* ========================================================================= */
+// Double to text - Grisu3 (Loitsch, "Printing floating-point numbers quickly and accurately with integers")
+/* ========================================================================= */
+typedef struct { // f * 2^e
+    uint64_t f;
+    int e;
+} vn_fp_t;
+
+typedef struct { // 10^k ~ f * 2^e
+    uint64_t f;
+    int e;
+    int k;
+} vn_pow_t;
+
+// Normalized 10^k for k = -300, -292 ... 324 - one of them brings any double exponent to [-60, -32]
+static const vn_pow_t vn_cached[79] = {
+    { 0xAB70FE17C79AC6CAULL, -1060, -300 },
+    { 0xFF77B1FCBEBCDC4FULL, -1034, -292 },
+    { 0xBE5691EF416BD60CULL, -1007, -284 },
+    { 0x8DD01FAD907FFC3CULL,  -980, -276 },
+    { 0xD3515C2831559A83ULL,  -954, -268 },
+    { 0x9D71AC8FADA6C9B5ULL,  -927, -260 },
+    { 0xEA9C227723EE8BCBULL,  -901, -252 },
+    { 0xAECC49914078536DULL,  -874, -244 },
+    { 0x823C12795DB6CE57ULL,  -847, -236 },
+    { 0xC21094364DFB5637ULL,  -821, -228 },
+    { 0x9096EA6F3848984FULL,  -794, -220 },
+    { 0xD77485CB25823AC7ULL,  -768, -212 },
+    { 0xA086CFCD97BF97F4ULL,  -741, -204 },
+    { 0xEF340A98172AACE5ULL,  -715, -196 },
+    { 0xB23867FB2A35B28EULL,  -688, -188 },
+    { 0x84C8D4DFD2C63F3BULL,  -661, -180 },
+    { 0xC5DD44271AD3CDBAULL,  -635, -172 },
+    { 0x936B9FCEBB25C996ULL,  -608, -164 },
+    { 0xDBAC6C247D62A584ULL,  -582, -156 },
+    { 0xA3AB66580D5FDAF6ULL,  -555, -148 },
+    { 0xF3E2F893DEC3F126ULL,  -529, -140 },
+    { 0xB5B5ADA8AAFF80B8ULL,  -502, -132 },
+    { 0x87625F056C7C4A8BULL,  -475, -124 },
+    { 0xC9BCFF6034C13053ULL,  -449, -116 },
+    { 0x964E858C91BA2655ULL,  -422, -108 },
+    { 0xDFF9772470297EBDULL,  -396, -100 },
+    { 0xA6DFBD9FB8E5B88FULL,  -369,  -92 },
+    { 0xF8A95FCF88747D94ULL,  -343,  -84 },
+    { 0xB94470938FA89BCFULL,  -316,  -76 },
+    { 0x8A08F0F8BF0F156BULL,  -289,  -68 },
+    { 0xCDB02555653131B6ULL,  -263,  -60 },
+    { 0x993FE2C6D07B7FACULL,  -236,  -52 },
+    { 0xE45C10C42A2B3B06ULL,  -210,  -44 },
+    { 0xAA242499697392D3ULL,  -183,  -36 },
+    { 0xFD87B5F28300CA0EULL,  -157,  -28 },
+    { 0xBCE5086492111AEBULL,  -130,  -20 },
+    { 0x8CBCCC096F5088CCULL,  -103,  -12 },
+    { 0xD1B71758E219652CULL,   -77,   -4 },
+    { 0x9C40000000000000ULL,   -50,    4 },
+    { 0xE8D4A51000000000ULL,   -24,   12 },
+    { 0xAD78EBC5AC620000ULL,     3,   20 },
+    { 0x813F3978F8940984ULL,    30,   28 },
+    { 0xC097CE7BC90715B3ULL,    56,   36 },
+    { 0x8F7E32CE7BEA5C70ULL,    83,   44 },
+    { 0xD5D238A4ABE98068ULL,   109,   52 },
+    { 0x9F4F2726179A2245ULL,   136,   60 },
+    { 0xED63A231D4C4FB27ULL,   162,   68 },
+    { 0xB0DE65388CC8ADA8ULL,   189,   76 },
+    { 0x83C7088E1AAB65DBULL,   216,   84 },
+    { 0xC45D1DF942711D9AULL,   242,   92 },
+    { 0x924D692CA61BE758ULL,   269,  100 },
+    { 0xDA01EE641A708DEAULL,   295,  108 },
+    { 0xA26DA3999AEF774AULL,   322,  116 },
+    { 0xF209787BB47D6B85ULL,   348,  124 },
+    { 0xB454E4A179DD1877ULL,   375,  132 },
+    { 0x865B86925B9BC5C2ULL,   402,  140 },
+    { 0xC83553C5C8965D3DULL,   428,  148 },
+    { 0x952AB45CFA97A0B3ULL,   455,  156 },
+    { 0xDE469FBD99A05FE3ULL,   481,  164 },
+    { 0xA59BC234DB398C25ULL,   508,  172 },
+    { 0xF6C69A72A3989F5CULL,   534,  180 },
+    { 0xB7DCBF5354E9BECEULL,   561,  188 },
+    { 0x88FCF317F22241E2ULL,   588,  196 },
+    { 0xCC20CE9BD35C78A5ULL,   614,  204 },
+    { 0x98165AF37B2153DFULL,   641,  212 },
+    { 0xE2A0B5DC971F303AULL,   667,  220 },
+    { 0xA8D9D1535CE3B396ULL,   694,  228 },
+    { 0xFB9B7CD9A4A7443CULL,   720,  236 },
+    { 0xBB764C4CA7A44410ULL,   747,  244 },
+    { 0x8BAB8EEFB6409C1AULL,   774,  252 },
+    { 0xD01FEF10A657842CULL,   800,  260 },
+    { 0x9B10A4E5E9913129ULL,   827,  268 },
+    { 0xE7109BFBA19C0C9DULL,   853,  276 },
+    { 0xAC2820D9623BF429ULL,   880,  284 },
+    { 0x80444B5E7AA7CF85ULL,   907,  292 },
+    { 0xBF21E44003ACDD2DULL,   933,  300 },
+    { 0x8E679C2F5E44FF8FULL,   960,  308 },
+    { 0xD433179D9C8CB841ULL,   986,  316 },
+    { 0x9E19DB92B4E31BA9ULL,  1013,  324 }
+};
+/* ========================================================================= */
+// Upper 64 bits of 128 bits product, rounded
+static vn_fp_t vn_fp_mul(vn_fp_t in_x, vn_fp_t in_y) {
+    uint64_t x_lo=in_x.f & 0xFFFFFFFFu, x_hi=in_x.f >> 32;
+    uint64_t y_lo=in_y.f & 0xFFFFFFFFu, y_hi=in_y.f >> 32;
+    uint64_t p0=x_lo*y_lo, p1=x_lo*y_hi, p2=x_hi*y_lo, p3=x_hi*y_hi;
+    uint64_t mid=(p0 >> 32) + (p1 & 0xFFFFFFFFu) + (p2 & 0xFFFFFFFFu) + (1ULL << 31);
+    vn_fp_t out;
+
+    out.f=p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+    out.e=in_x.e + in_y.e + 64;
+    return(out);
+}
+/* ========================================================================= */
+static vn_fp_t vn_fp_norm(vn_fp_t in_x) {
+
+    while(!(in_x.f >> 63)) {
+	in_x.f <<= 1;
+	in_x.e--;
+    }
+    return(in_x);
+}
+/* ========================================================================= */
+// Cut rest of last digit while it is closer to w and still inside unsafe interval
+// Returns 0 when the digits are not sure to be the shortest and closest - Grisu3 gave up
+static int vn_weed(char *io_buf, int in_len, uint64_t in_dist, uint64_t in_unsafe, uint64_t in_rest, uint64_t in_ten, uint64_t in_unit) {
+    uint64_t small=in_dist - in_unit; // too_high - w, +-unit of error
+    uint64_t big=in_dist + in_unit;
+
+    while(in_rest < small && in_unsafe - in_rest >= in_ten
+	  && (in_rest + in_ten < small || small - in_rest >= in_rest + in_ten - small)) {
+	io_buf[in_len-1]--;
+	in_rest += in_ten;
+    }
+
+    if(in_rest < big && in_unsafe - in_rest >= in_ten
+       && (in_rest + in_ten < big || big - in_rest > in_rest + in_ten - big)) return(0); // Next one down can be closer
+
+    return(2 * in_unit <= in_rest && in_rest <= in_unsafe - 4 * in_unit);
+}
+/* ========================================================================= */
+// Shortest digits of w inside (M-, M+) - all are scaled by 10^k, 0 - not sure
+static int vn_digits(char *out_buf, int *p_exp10, vn_fp_t in_minus, vn_fp_t in_w, vn_fp_t in_plus) {
+    uint64_t unit=1;                                // Error of scaled values
+    uint64_t high=in_plus.f + unit;                 // Same e for all three
+    uint64_t unsafe=high - (in_minus.f - unit);
+    uint64_t one=1ULL << -in_plus.e;
+    uint32_t p1=(uint32_t)(high >> -in_plus.e);     // Integer part - fits 32 bits as e is in [-60, -32]
+    uint64_t p2=high & (one - 1);                   // Fraction
+    uint32_t pow10=1000000000;
+    uint64_t rest=0;
+    int n=10;
+    int len=0;
+
+    while(n > 1 && p1 < pow10) {
+	pow10/=10;
+	n--;
+    }
+
+    while(n > 0) {
+	out_buf[len++]='0' + (char)(p1 / pow10);
+	p1 %= pow10;
+	n--;
+	if((rest=((uint64_t)p1 << -in_plus.e) + p2) < unsafe) {
+	    *p_exp10 += n;
+	    return(vn_weed(out_buf, len, high - in_w.f, unsafe, rest, (uint64_t)pow10 << -in_plus.e, unit) ? len : 0);
+	}
+	pow10/=10;
+    }
+
+    for(;;) { // Fraction digits
+	p2*=10;
+	unit*=10;
+	unsafe*=10;
+	out_buf[len++]='0' + (char)(p2 >> -in_plus.e);
+	p2&=one - 1;
+	(*p_exp10)--;
+	if(p2 < unsafe) break;
+    }
+
+    return(vn_weed(out_buf, len, (high - in_w.f) * unit, unsafe, p2, one, unit) ? len : 0);
+}
+/* ========================================================================= */
+// Finite positive in_dnum to digits and their exponent: in_dnum == digits * 10^exp10
+// Grisu3 - returns 0 for about 0.5% of doubles it can not be sure about
+static int vn_grisu3(double in_dnum, char *out_buf, int *p_exp10) {
+    uint64_t bits=0;
+    uint64_t frac=0;
+    int bexp=0;
+    vn_fp_t v, w, plus, minus;
+    vn_fp_t c;
+    const vn_pow_t *pw=NULL;
+    int f=0, k=0;
+
+    memcpy(&bits, &in_dnum, sizeof(bits));
+    frac=bits & ((1ULL << 52) - 1);
+    bexp=(int)(bits >> 52) & 0x7FF;
+
+    if(bexp) {
+	v.f=frac | (1ULL << 52);
+	v.e=bexp - 1075;
+    } else { // Subnormal
+	v.f=frac;
+	v.e=1 - 1075;
+    }
+
+    // Boundaries - halfway to neighbours, lower one is closer for powers of 2
+    plus.f=(v.f << 1) + 1;
+    plus.e=v.e - 1;
+    if(!frac && bexp > 1) {
+	minus.f=(v.f << 2) - 1;
+	minus.e=v.e - 2;
+    } else {
+	minus.f=(v.f << 1) - 1;
+	minus.e=v.e - 1;
+    }
+    plus=vn_fp_norm(plus);
+    minus.f <<= minus.e - plus.e;
+    minus.e=plus.e;
+    w=vn_fp_norm(v); // Gets plus.e too
+
+    // 10^k to bring plus.e to [-60, -32]
+    f=-60 - plus.e - 1;
+    k=(f * 78913) / (1 << 18) + (f > 0); // ceil(f * log10(2))
+    pw=&vn_cached[(300 + k + 7) / 8];
+    c.f=pw->f;
+    c.e=pw->e;
+
+    w=vn_fp_mul(w, c);
+    plus=vn_fp_mul(plus, c);
+    minus=vn_fp_mul(minus, c);
+
+    *p_exp10=-pw->k;
+    return(vn_digits(out_buf, p_exp10, minus, w, plus));
+}
+/* ========================================================================= */
+// Fallback of vn_grisu3() - first of 15, 16, 17 digits what reads back the same, by printf()
+static int vn_printf(double in_dnum, char *out_buf, int *p_exp10) {
+    char buf[40];
+    char *e=NULL;
+    int prec=15;
+    int len=0;
+
+    for(prec=15; prec < 17; prec++) {
+	snprintf(buf, sizeof(buf), "%.*e", prec-1, in_dnum);
+	if(strtod(buf, NULL) == in_dnum) break;
+    }
+    if(prec == 17) snprintf(buf, sizeof(buf), "%.16e", in_dnum);
+
+    // d.ddde+XX
+    out_buf[len++]=buf[0];
+    for(e=buf+2; *e >= '0' && *e <= '9'; e++) out_buf[len++]=*e;
+    *p_exp10=atoi(e+1) - (len-1);
+
+    return(len);
+}
+/* ========================================================================= */
+// Shortest text what reads back to the same double, laid out as printf("%.17g")
+// out_str has to keep V2_NUM_DTOA_LEN bytes, returns text length
+int v2_num_dtoa(double in_dnum, char *out_str) {
+    char dig[20];
+    char *out=out_str;
+    int exp10=0;
+    int len=0;
+    int x=0;
+    int i=0;
+
+    if(isnan(in_dnum) || isinf(in_dnum)) return(sprintf(out_str, "%g", in_dnum)); // As before - not json anyway
+
+    if(signbit(in_dnum)) {
+	*out++='-';
+	in_dnum=-in_dnum;
+    }
+
+    if(in_dnum == 0) {
+	*out++='0';
+	*out='\0';
+	return(out-out_str);
+    }
+
+    if(!(len=vn_grisu3(in_dnum, dig, &exp10))) len=vn_printf(in_dnum, dig, &exp10);
+    while(len > 1 && dig[len-1] == '0') { // Rounding can leave them
+	len--;
+	exp10++;
+    }
+    x=len + exp10 - 1; // Exponent of first digit
+
+    if(x < -4 || x >= 17) { // d.ddde+XX
+	*out++=dig[0];
+	if(len > 1) {
+	    *out++='.';
+	    memcpy(out, dig+1, len-1);
+	    out+=len-1;
+	}
+	*out++='e';
+	*out++=x < 0?'-':'+';
+	if(x < 0) x=-x;
+	if(x >= 100) *out++='0' + x/100;
+	*out++='0' + (x/10)%10;
+	*out++='0' + x%10;
+    } else if(x < 0) { // 0.000ddd
+	*out++='0';
+	*out++='.';
+	for(i=-1; i > x; i--) *out++='0';
+	memcpy(out, dig, len);
+	out+=len;
+    } else if(len <= x+1) { // ddd000
+	memcpy(out, dig, len);
+	out+=len;
+	for(i=len; i <= x; i++) *out++='0';
+    } else { // ddd.ddd
+	memcpy(out, dig, x+1);
+	out+=x+1;
+	*out++='.';
+	memcpy(out, dig+x+1, len-x-1);
+	out+=len-x-1;
+    }
+
+    *out='\0';
+    return(out-out_str);
+}
+/* ========================================================================= */
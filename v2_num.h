@@ -0,0 +1,41 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _V2_NUM_H
+#define _V2_NUM_H 1
+
+/*
+ * Json numbers by text span (no '\0' needed): integer fast path with overflow check,
+ * exact double by one multiply or divide when it is possible (Clinger), else strtod().
+ * Back to text: shortest digits what read to the same double (Grisu3, printf() for rare doubles it gives up on).
+ */
+
+#include <stdlib.h>
+
+// v2_num_parse() returns
+#define V2_NUM_NONE   0 // Not json number
+#define V2_NUM_LONG   1 // *p_lnum is set
+#define V2_NUM_DOUBLE 2 // *p_dnum is set - has fraction or exponent, or integer does not fit long long
+
+int v2_num_parse(const char *in_str, size_t in_len, long long *p_lnum, double *p_dnum);
+
+// Double as text - layout of "%.17g" with shortest round-trip digits: 0.1, 1e+100, 12345678, 1.5e-07
+#define V2_NUM_DTOA_LEN 32 // Enough for any double with '\0'
+int v2_num_dtoa(double in_dnum, char *out_str); // Returns text length
+
+#endif // _V2_NUM_H
@@ -0,0 +1,609 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <pthread.h>
+
+#include "v2_sidx.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define VS_X86 1
+#include <immintrin.h>
+#endif
+
+// One 64 bytes block masks, bit N == byte N
+typedef struct {
+    uint64_t quote; // '"'
+    uint64_t bs;    // '\\'
+    uint64_t op;    // '{', '}', '[', ']', ':', ','
+    uint64_t ws;    // ' ', '\t', '\r', '\n' - the same as jsmn skips
+    uint64_t nul;   // '\0' - jsmn stops there
+} vs_blk_t;
+
+typedef void (*vs_class_f)(const unsigned char *, vs_blk_t *);
+
+// Stage 2 state
+typedef struct {
+    jsmntok_t *tok;
+    int tmax;
+    int next;  // == jsmn_parser.toknext
+    int super; // == jsmn_parser.toksuper
+
+    int *stk;  // Opened objects and arrays
+    int sdep;
+    int smax;
+} vs_state_t;
+
+// Stage 1 state - goes by 64 bytes blocks
+typedef struct {
+    const char *js;
+    size_t len;
+    vs_class_f class_fun;
+    unsigned char tail[64];
+
+    size_t base;         // Current block offset
+    uint64_t prev_odd;   // Previous block ended by odd backslash sequence
+    uint64_t prev_in;    // Previous block ended inside of string (all ones)
+    uint64_t prev_other; // Previous block ended by primitive char
+    int is_end;          // '\0' found
+
+    uint64_t events; // Current block: structural chars, quotas, primitive starts
+    uint64_t quote;  // Current block: not escaped quotas
+    uint64_t bs;     // Current block: backslashes inside of strings
+} vs_scan_t;
+
+#define VS_C_QUOTE 1
+#define VS_C_BS    2
+#define VS_C_OP    4
+#define VS_C_WS    8
+#define VS_C_NUL   16
+
+static const unsigned char vs_ctab[256] = {
+    ['"']=VS_C_QUOTE, ['\\']=VS_C_BS,
+    ['{']=VS_C_OP, ['}']=VS_C_OP, ['[']=VS_C_OP, [']']=VS_C_OP, [':']=VS_C_OP, [',']=VS_C_OP,
+    [' ']=VS_C_WS, ['\t']=VS_C_WS, ['\r']=VS_C_WS, ['\n']=VS_C_WS,
+    [0]=VS_C_NUL
+};
+
+/* ========================================================================= */
+static void vs_class_scalar(const unsigned char *in_p, vs_blk_t *p_m) {
+    uint64_t bit=1;
+    int x=0;
+
+    memset(p_m, 0, sizeof(vs_blk_t));
+
+    for(x=0; x<64; x++, bit<<=1) {
+	switch(vs_ctab[in_p[x]]) {
+	case VS_C_QUOTE: p_m->quote |= bit; break;
+	case VS_C_BS:    p_m->bs    |= bit; break;
+	case VS_C_OP:    p_m->op    |= bit; break;
+	case VS_C_WS:    p_m->ws    |= bit; break;
+	case VS_C_NUL:   p_m->nul   |= bit; break;
+	}
+    }
+}
+#ifdef VS_X86
+/* ========================================================================= */
+static void vs_class_sse2(const unsigned char *in_p, vs_blk_t *p_m) {
+    const __m128i c_quote = _mm_set1_epi8('"');
+    const __m128i c_bs    = _mm_set1_epi8('\\');
+    const __m128i c_20    = _mm_set1_epi8(0x20);
+    const __m128i c_open  = _mm_set1_epi8('{'); // '[' | 0x20
+    const __m128i c_close = _mm_set1_epi8('}'); // ']' | 0x20
+    const __m128i c_colon = _mm_set1_epi8(':');
+    const __m128i c_comma = _mm_set1_epi8(',');
+    const __m128i c_tab   = _mm_set1_epi8('\t');
+    const __m128i c_cr    = _mm_set1_epi8('\r');
+    const __m128i c_lf    = _mm_set1_epi8('\n');
+    const __m128i c_nul   = _mm_setzero_si128();
+    __m128i v, vl, op, ws;
+    int x=0;
+
+    memset(p_m, 0, sizeof(vs_blk_t));
+
+    for(x=0; x<4; x++) {
+	v  = _mm_loadu_si128((const __m128i *)(in_p+16*x));
+	vl = _mm_or_si128(v, c_20);
+
+	op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(vl, c_open), _mm_cmpeq_epi8(vl, c_close)),
+			  _mm_or_si128(_mm_cmpeq_epi8(v, c_colon), _mm_cmpeq_epi8(v, c_comma)));
+	ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, c_20), _mm_cmpeq_epi8(v, c_tab)),
+			  _mm_or_si128(_mm_cmpeq_epi8(v, c_cr), _mm_cmpeq_epi8(v, c_lf)));
+
+	p_m->quote |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, c_quote)) << (16*x);
+	p_m->bs    |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, c_bs))    << (16*x);
+	p_m->nul   |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, c_nul))   << (16*x);
+	p_m->op    |= (uint64_t)(uint16_t)_mm_movemask_epi8(op) << (16*x);
+	p_m->ws    |= (uint64_t)(uint16_t)_mm_movemask_epi8(ws) << (16*x);
+    }
+}
+/* ========================================================================= */
+__attribute__((target("avx2")))
+static void vs_class_avx2(const unsigned char *in_p, vs_blk_t *p_m) {
+    const __m256i c_quote = _mm256_set1_epi8('"');
+    const __m256i c_bs    = _mm256_set1_epi8('\\');
+    const __m256i c_20    = _mm256_set1_epi8(0x20);
+    const __m256i c_open  = _mm256_set1_epi8('{');
+    const __m256i c_close = _mm256_set1_epi8('}');
+    const __m256i c_colon = _mm256_set1_epi8(':');
+    const __m256i c_comma = _mm256_set1_epi8(',');
+    const __m256i c_tab   = _mm256_set1_epi8('\t');
+    const __m256i c_cr    = _mm256_set1_epi8('\r');
+    const __m256i c_lf    = _mm256_set1_epi8('\n');
+    const __m256i c_nul   = _mm256_setzero_si256();
+    __m256i v, vl, op, ws;
+    int x=0;
+
+    memset(p_m, 0, sizeof(vs_blk_t));
+
+    for(x=0; x<2; x++) {
+	v  = _mm256_loadu_si256((const __m256i *)(in_p+32*x));
+	vl = _mm256_or_si256(v, c_20);
+
+	op = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(vl, c_open), _mm256_cmpeq_epi8(vl, c_close)),
+			     _mm256_or_si256(_mm256_cmpeq_epi8(v, c_colon), _mm256_cmpeq_epi8(v, c_comma)));
+	ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, c_20), _mm256_cmpeq_epi8(v, c_tab)),
+			     _mm256_or_si256(_mm256_cmpeq_epi8(v, c_cr), _mm256_cmpeq_epi8(v, c_lf)));
+
+	p_m->quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, c_quote)) << (32*x);
+	p_m->bs    |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, c_bs))    << (32*x);
+	p_m->nul   |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, c_nul))   << (32*x);
+	p_m->op    |= (uint64_t)(uint32_t)_mm256_movemask_epi8(op) << (32*x);
+	p_m->ws    |= (uint64_t)(uint32_t)_mm256_movemask_epi8(ws) << (32*x);
+    }
+}
+#endif // VS_X86
+/* ========================================================================= */
+static int vs_level=0; // Set once for all threads
+
+static void vs_level_init(void) {
+#ifdef VS_X86
+    __builtin_cpu_init();
+    vs_level=__builtin_cpu_supports("avx2")?V2_SIDX_AVX2:V2_SIDX_SSE2;
+#else
+    vs_level=V2_SIDX_SCALAR;
+#endif
+}
+/* ========================================================================= */
+int v2_sidx_level(void) {
+    static pthread_once_t once=PTHREAD_ONCE_INIT;
+
+    pthread_once(&once, vs_level_init);
+
+    return(vs_level);
+}
+/* ========================================================================= */
+static vs_class_f vs_class_fun(int in_level) {
+
+    if(in_level == V2_SIDX_AUTO) in_level=v2_sidx_level();
+    if(in_level > v2_sidx_level()) in_level=v2_sidx_level(); // CPU does not support asked one
+
+#ifdef VS_X86
+    if(in_level == V2_SIDX_AVX2) return(&vs_class_avx2);
+    if(in_level == V2_SIDX_SSE2) return(&vs_class_sse2);
+#endif
+    return(&vs_class_scalar);
+}
+/* ========================================================================= */
+// Bytes escaped by odd length backslash sequences (simdjson way)
+static uint64_t vs_escaped(uint64_t in_bs, uint64_t *p_odd) {
+    const uint64_t even_bits = 0x5555555555555555ULL;
+    const uint64_t odd_bits  = ~even_bits;
+    uint64_t start_edges = in_bs & ~(in_bs << 1);
+    uint64_t even_start_mask = even_bits ^ *p_odd; // Odd sequence at the end of previous block flips the sense
+    uint64_t even_starts = start_edges & even_start_mask;
+    uint64_t odd_starts  = start_edges & ~even_start_mask;
+    uint64_t even_carries = in_bs + even_starts;
+    uint64_t odd_carries  = in_bs + odd_starts;
+    int ends_odd = odd_carries < in_bs; // Carry out of bit 63
+
+    odd_carries |= *p_odd;
+    *p_odd = ends_odd;
+
+    return(((even_carries & ~in_bs) & odd_bits) | ((odd_carries & ~in_bs) & even_bits));
+}
+/* ========================================================================= */
+// Bit N is XOR of bits 0..N - ones inside quotas
+static uint64_t vs_prefix_xor(uint64_t in_bits) {
+
+    in_bits ^= in_bits << 1;
+    in_bits ^= in_bits << 2;
+    in_bits ^= in_bits << 4;
+    in_bits ^= in_bits << 8;
+    in_bits ^= in_bits << 16;
+    in_bits ^= in_bits << 32;
+
+    return(in_bits);
+}
+/* ========================================================================= */
+static jsmntok_t *vs_token(vs_state_t *in_st) {
+    jsmntok_t *tok_tmp=NULL;
+
+    if(in_st->next >= in_st->tmax) {
+	if(in_st->tmax > (1<<30)) return(NULL);
+	if(!(tok_tmp=(jsmntok_t *)realloc(in_st->tok, (in_st->tmax*2+16)*sizeof(jsmntok_t)))) return(NULL);
+	in_st->tok=tok_tmp;
+	in_st->tmax=in_st->tmax*2+16;
+    }
+
+    tok_tmp=&in_st->tok[in_st->next++];
+    tok_tmp->start = tok_tmp->end = -1;
+    tok_tmp->size = 0;
+
+    return(tok_tmp);
+}
+/* ========================================================================= */
+// Check escapes the way jsmn_parse_string() does
+static int vs_string_ok(const char *in_js, size_t in_start, size_t in_end) {
+    size_t x=0;
+    int y=0;
+
+    for(x=in_start; x<in_end; x++) {
+	if(in_js[x] != '\\') continue;
+	switch(in_js[++x]) {
+	case '\"': case '/': case '\\': case 'b': case 'f': case 'r': case 'n': case 't':
+	    break;
+	case 'u':
+	    for(y=0; y<4; y++) {
+		if(!strchr("0123456789ABCDEFabcdef", in_js[++x]) || !in_js[x]) return(0);
+	    }
+	    break;
+	default:
+	    return(0);
+	}
+    }
+    return(1);
+}
+/* ========================================================================= */
+static void vs_scan_init(vs_scan_t *in_sc, int in_level, const char *in_js, size_t in_len) {
+
+    memset(in_sc, 0, sizeof(vs_scan_t));
+    in_sc->js=in_js;
+    in_sc->len=in_len;
+    in_sc->class_fun=vs_class_fun(in_level);
+}
+/* ========================================================================= */
+// Masks for block at in_sc->base, 0 - no more blocks
+static int vs_scan_block(vs_scan_t *in_sc) {
+    const unsigned char *blk=NULL;
+    uint64_t lim, odd, in_str, other, bits;
+    vs_blk_t m;
+
+    if(in_sc->base >= in_sc->len || in_sc->is_end) return(0);
+
+    blk=(const unsigned char *)in_sc->js+in_sc->base;
+    lim=~0ULL;
+
+    if(in_sc->len-in_sc->base < 64) { // Last block
+	memset(in_sc->tail, 0, 64);
+	memcpy(in_sc->tail, blk, in_sc->len-in_sc->base);
+	blk=in_sc->tail;
+	lim=(1ULL<<(in_sc->len-in_sc->base))-1;
+    }
+
+    in_sc->class_fun(blk, &m);
+
+    if((bits=m.nul & lim)) { // jsmn stops at first '\0'
+	lim &= (bits & -bits)-1;
+	in_sc->is_end=1;
+    }
+
+    odd    = vs_escaped(m.bs, &in_sc->prev_odd);
+    in_sc->quote = m.quote & ~odd & lim;
+    in_str = vs_prefix_xor(in_sc->quote) ^ in_sc->prev_in;
+    in_sc->prev_in = (uint64_t)((int64_t)in_str >> 63);
+
+    other  = ~(m.op | m.ws | in_sc->quote) & ~in_str;
+    in_sc->events = ((m.op & ~in_str) | in_sc->quote | (other & ~((other << 1) | in_sc->prev_other))) & lim;
+    in_sc->prev_other = other >> 63;
+
+    in_sc->bs = m.bs & in_str & lim; // Backslashes inside of strings
+
+    return(1);
+}
+/* ========================================================================= */
+// String closed by quota at block bit in_bit: 0 - wrong escapes, 1 - no backslashes, 2 - escapes are ok
+static int vs_scan_string(vs_scan_t *in_sc, int in_bit, size_t in_open, size_t *p_bs_last) {
+    uint64_t bits;
+
+    if((bits=in_sc->bs & ((1ULL<<in_bit)-1))) *p_bs_last=in_sc->base+63-__builtin_clzll(bits);
+    if((*p_bs_last != (size_t)-1) && (*p_bs_last > in_open)) {
+	return(vs_string_ok(in_sc->js, in_open+1, in_sc->base+in_bit)?2:0);
+    }
+    return(1);
+}
+/* ========================================================================= */
+// Primitive end - the same chars jsmn_parse_primitive() stops on, (size_t)-1 if jsmn reads it other way
+static size_t vs_primitive_end(const char *in_js, size_t in_len, size_t in_pos) {
+    char c;
+
+    for(; in_pos<in_len && in_js[in_pos]; in_pos++) {
+	c=in_js[in_pos];
+	if(c==':' || c=='\t' || c=='\r' || c=='\n' || c==' ' || c==',' || c==']' || c=='}') break;
+	if(c < 32 || c >= 127 || c == '"') return((size_t)-1); // jsmn error or quota jsmn takes into primitive
+    }
+    return(in_pos);
+}
+/* ========================================================================= */
+int v2_sidx_parse(int in_level, const char *in_js, size_t in_len, jsmntok_t **p_tok, int *p_max) {
+    vs_scan_t sc;
+    vs_state_t st;
+    jsmntok_t *tok=NULL;
+    uint64_t events;
+    size_t pos=0;
+    size_t skip=0;            // Events below it are inside of primitive
+    size_t str_open=0;        // Opening quota of current string
+    size_t bs_last=(size_t)-1; // Last backslash inside of string
+    int is_str=0;
+    int rc=V2_SIDX_SLOW;
+    int i=0;
+    char c;
+
+    memset(&st, 0, sizeof(st));
+    st.tok=*p_tok;
+    st.tmax=*p_max;
+    st.super=-1;
+
+    for(vs_scan_init(&sc, in_level, in_js, in_len); vs_scan_block(&sc); sc.base+=64) {
+	events=sc.events;
+
+	while(events) {
+	    i=__builtin_ctzll(events);
+	    events &= events-1;
+	    pos=sc.base+i;
+
+	    if(pos < skip) continue; // jsmn reads it as a part of primitive
+
+	    if((sc.quote >> i) & 1) {
+		if(!is_str) {
+		    is_str=1;
+		    str_open=pos;
+		    continue;
+		}
+		is_str=0;
+
+		if(!vs_scan_string(&sc, i, str_open, &bs_last)) goto out;
+
+		if(!(tok=vs_token(&st))) { rc=JSMN_ERROR_NOMEM; goto out; }
+		tok->type  = JSMN_STRING;
+		tok->start = str_open+1;
+		tok->end   = pos;
+		if(st.super != -1) st.tok[st.super].size++;
+		continue;
+	    }
+
+	    c=in_js[pos];
+	    switch(c) {
+	    case '{':
+	    case '[':
+		if(!(tok=vs_token(&st))) { rc=JSMN_ERROR_NOMEM; goto out; }
+		if(st.super != -1) st.tok[st.super].size++;
+		tok->type  = (c == '{' ? JSMN_OBJECT : JSMN_ARRAY);
+		tok->start = pos;
+		st.super = st.next-1;
+
+		if(st.sdep >= st.smax) {
+		    int *stk_tmp=NULL;
+		    if(!(stk_tmp=(int *)realloc(st.stk, (st.smax*2+64)*sizeof(int)))) { rc=JSMN_ERROR_NOMEM; goto out; }
+		    st.stk=stk_tmp;
+		    st.smax=st.smax*2+64;
+		}
+		st.stk[st.sdep++]=st.super;
+		break;
+	    case '}':
+	    case ']':
+		if(!st.sdep) goto out; // Unmatched
+		tok=&st.tok[st.stk[--st.sdep]];
+		if(tok->type != (c == '}' ? JSMN_OBJECT : JSMN_ARRAY)) goto out;
+		tok->end = pos+1;
+		st.super = st.sdep?st.stk[st.sdep-1]:-1;
+		break;
+	    case ':':
+		st.super = st.next-1;
+		break;
+	    case ',':
+		if((st.super != -1) && (st.tok[st.super].type != JSMN_ARRAY) && (st.tok[st.super].type != JSMN_OBJECT)) {
+		    if(st.sdep) st.super=st.stk[st.sdep-1];
+		}
+		break;
+	    default: // Primitive
+		if((skip=vs_primitive_end(in_js, in_len, pos)) == (size_t)-1) goto out;
+		if(!(tok=vs_token(&st))) { rc=JSMN_ERROR_NOMEM; goto out; }
+		tok->type  = JSMN_PRIMITIVE;
+		tok->start = pos;
+		tok->end   = skip;
+		if(st.super != -1) st.tok[st.super].size++;
+		break;
+	    }
+	}
+
+	if(sc.bs) bs_last=sc.base+63-__builtin_clzll(sc.bs);
+    }
+
+    if(!is_str && !st.sdep) rc=st.next; // Else let jsmn_parse() give right error
+
+ out:
+    free(st.stk);
+    *p_tok=st.tok;
+    *p_max=st.tmax;
+
+    return(rc);
+}
+/* ========================================================================= */
+// Tape grammar states
+#define VS_W_VAL   1 // Value
+#define VS_W_KEY   2 // Member name
+#define VS_W_COLON 3 // ':' after name
+#define VS_W_NEXT  4 // ',' or close
+#define VS_W_END   5 // Nothing but spaces
+#define VS_W_EMPTY 8 // Flag: close is allowed - container just opened
+
+/* ========================================================================= */
+static int vs_tape_add(v2_tape_t *in_tape, int in_type, size_t in_val) {
+    uint64_t *w_tmp=NULL;
+
+    if(in_tape->cnt >= in_tape->max) {
+	if(!(w_tmp=(uint64_t *)realloc(in_tape->w, (in_tape->max*2+64)*sizeof(uint64_t)))) return(JSMN_ERROR_NOMEM);
+	in_tape->w=w_tmp;
+	in_tape->max=in_tape->max*2+64;
+    }
+    in_tape->w[in_tape->cnt++]=V2_TAPE_WORD(in_type, in_val);
+
+    return(0);
+}
+/* ========================================================================= */
+int v2_sidx_tape(int in_level, const char *in_js, size_t in_len, v2_tape_t *io_tape) {
+    vs_scan_t sc;
+    uint64_t events;
+    size_t *stk=NULL; // Opened objects and arrays - tape indexes
+    size_t sdep=0;
+    size_t smax=0;
+    size_t pos=0;
+    size_t skip=0;
+    size_t str_open=0;
+    size_t bs_last=(size_t)-1;
+    size_t open=0;
+    int want=VS_W_VAL;
+    int esc=0;
+    int is_str=0;
+    int rc=V2_SIDX_SLOW;
+    int i=0;
+    char c;
+
+    io_tape->cnt=0;
+
+    for(vs_scan_init(&sc, in_level, in_js, in_len); vs_scan_block(&sc); sc.base+=64) {
+	events=sc.events;
+
+	while(events) {
+	    i=__builtin_ctzll(events);
+	    events &= events-1;
+	    pos=sc.base+i;
+
+	    if(pos < skip) continue;
+
+	    if((sc.quote >> i) & 1) {
+		if(!is_str) {
+		    is_str=1;
+		    str_open=pos;
+		    continue;
+		}
+		is_str=0;
+
+		if(!(esc=vs_scan_string(&sc, i, str_open, &bs_last))) goto out;
+		esc=(esc == 2)?V2_TAPE_ESC_FLAG:0;
+
+		if((want & ~VS_W_EMPTY) == VS_W_KEY) {
+		    if(vs_tape_add(io_tape, 'k' | esc, str_open+1)) { rc=JSMN_ERROR_NOMEM; goto out; }
+		    want=VS_W_COLON;
+		} else if((want & ~VS_W_EMPTY) == VS_W_VAL && sdep) {
+		    if(vs_tape_add(io_tape, '"' | esc, str_open+1)) { rc=JSMN_ERROR_NOMEM; goto out; }
+		    want=VS_W_NEXT;
+		} else goto out;
+		continue;
+	    }
+
+	    c=in_js[pos];
+
+	    switch(c) {
+	    case '{':
+	    case '[':
+		if((want & ~VS_W_EMPTY) != VS_W_VAL) goto out;
+		if(sdep >= smax) {
+		    size_t *stk_tmp=NULL;
+		    if(!(stk_tmp=(size_t *)realloc(stk, (smax*2+64)*sizeof(size_t)))) { rc=JSMN_ERROR_NOMEM; goto out; }
+		    stk=stk_tmp;
+		    smax=smax*2+64;
+		}
+		stk[sdep++]=io_tape->cnt;
+		if(vs_tape_add(io_tape, c, 0)) { rc=JSMN_ERROR_NOMEM; goto out; } // Jump is set on close
+		want=(c == '{' ? VS_W_KEY : VS_W_VAL) | VS_W_EMPTY;
+		break;
+	    case '}':
+	    case ']':
+		if(want != VS_W_NEXT && !(want & VS_W_EMPTY)) goto out; // No value after ',' or ':'
+		if(!sdep) goto out;
+		open=stk[--sdep];
+		if(V2_TAPE_TYPE(io_tape->w[open]) != (c == '}' ? '{' : '[')) goto out;
+		io_tape->w[open]=V2_TAPE_WORD(V2_TAPE_TYPE(io_tape->w[open]), io_tape->cnt);
+		if(vs_tape_add(io_tape, c, open)) { rc=JSMN_ERROR_NOMEM; goto out; }
+		want=sdep?VS_W_NEXT:VS_W_END;
+		break;
+	    case ':':
+		if(want != VS_W_COLON) goto out;
+		want=VS_W_VAL;
+		break;
+	    case ',':
+		if(want != VS_W_NEXT) goto out;
+		want=(V2_TAPE_TYPE(io_tape->w[stk[sdep-1]]) == '{' ? VS_W_KEY : VS_W_VAL);
+		break;
+	    default: // Primitive
+		if((want & ~VS_W_EMPTY) != VS_W_VAL || !sdep) goto out;
+		if((skip=vs_primitive_end(in_js, in_len, pos)) == (size_t)-1) goto out;
+		if(vs_tape_add(io_tape, 'p', pos)) { rc=JSMN_ERROR_NOMEM; goto out; }
+		want=VS_W_NEXT;
+		break;
+	    }
+	}
+
+	if(sc.bs) bs_last=sc.base+63-__builtin_clzll(sc.bs);
+    }
+
+    if(want == VS_W_END && !is_str) rc=0;
+
+ out:
+    free(stk);
+    if(rc) io_tape->cnt=0;
+
+    return(rc);
+}
+/* ========================================================================= */
+void v2_tape_free(v2_tape_t *in_tape) {
+
+    if(!in_tape) return;
+
+    free(in_tape->w);
+    memset(in_tape, 0, sizeof(v2_tape_t));
+}
+/* ========================================================================= */
+size_t v2_tape_len(const char *in_js, size_t in_len, uint64_t in_w) {
+    size_t start=V2_TAPE_VAL(in_w);
+    size_t pos=start;
+    size_t bs=0;
+    const char *p=NULL;
+
+    switch(V2_TAPE_TYPE(in_w)) {
+    case 'k':
+    case '"':
+	if(!V2_TAPE_ESC(in_w)) { // No backslashes - first quota
+	    if((p=memchr(in_js+pos, '"', in_len-pos))) return(p-in_js-start);
+	    return(in_len-start);
+	}
+	while((p=memchr(in_js+pos, '"', in_len-pos))) { // Quota after even number of backslashes
+	    pos=p-in_js;
+	    for(bs=0; pos-bs > start && in_js[pos-bs-1] == '\\'; bs++);
+	    if(!(bs & 1)) return(pos-start);
+	    pos++;
+	}
+	return(in_len-start);
+    case 'p':
+	return(vs_primitive_end(in_js, in_len, start)-start); // Checked by v2_sidx_tape()
+    }
+    return(0);
+}
+/* ========================================================================= */
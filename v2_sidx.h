@@ -0,0 +1,79 @@
+/*
+ *  Copyright (c) 2015-2016 Oleg Vlasenko <vop@unity.net>
+ *  All Rights Reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _V2_SIDX_H
+#define _V2_SIDX_H 1
+
+/*
+ * Structural indexer - the other way to get jsmn tokens.
+ * Stage 1 finds quotes, backslashes and structural chars by 64 bytes blocks
+ * (bitmasks), stage 2 walks found positions and fills the same jsmntok_t array
+ * as jsmn_parse() over fresh parser does.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define JSMN_HEADER 1
+#include "jsmn.h"
+
+// Stage 1 levels
+#define V2_SIDX_AUTO   0 // Best level supported by CPU
+#define V2_SIDX_SCALAR 1 // Plain C, any CPU
+#define V2_SIDX_SSE2   2 // x86_64 base level
+#define V2_SIDX_AVX2   3 // Checked at run time
+
+// Returned if text has something what only jsmn_parse() knows how to handle (broken json mostly)
+#define V2_SIDX_SLOW -10
+
+// Tape - compact tokens: one 64 bits word per value, size_t offsets (no 2 GB limit of jsmntok_t)
+// High byte is type, low 56 bits are payload:
+//   '{' '[' - tape index of the matching '}' ']' (jump over the value)
+//   '}' ']' - tape index of the opening word
+//   'k'     - object member name: text offset after the opening quota
+//   '"'     - string: text offset after the opening quota
+//   'p'     - primitive: text offset of the first char
+// Scalars length is not stored - v2_tape_len() finds it by text
+// High bit of type byte (V2_TAPE_ESC) marks name or string with backslashes - needs unescape
+#define V2_TAPE_TYPE(w) ((char)(((w) >> 56) & 0x7F))
+#define V2_TAPE_VAL(w)  ((size_t)((w) & 0x00FFFFFFFFFFFFFFULL))
+#define V2_TAPE_ESC(w)  ((int)((w) >> 63))
+#define V2_TAPE_WORD(t, v) (((uint64_t)(unsigned char)(t) << 56) | (uint64_t)(v))
+#define V2_TAPE_ESC_FLAG 0x80
+
+typedef struct {
+    uint64_t *w; // Words
+    size_t cnt;  // Used words
+    size_t max;  // Allocated words
+} v2_tape_t;
+
+int v2_sidx_level(void); // Best level supported by CPU
+
+// Returns tokens number like jsmn_parse(), JSMN_ERROR_NOMEM on realloc fail or V2_SIDX_SLOW
+// *p_tok is realloc()-ed as needed, *p_max keeps allocated tokens number
+int v2_sidx_parse(int in_level, const char *in_js, size_t in_len, jsmntok_t **p_tok, int *p_max);
+
+// Fills tape by strict json (one root object or array, trailing spaces only)
+// Returns 0, JSMN_ERROR_NOMEM or V2_SIDX_SLOW if jsmn_parse() has to decide what text means
+int v2_sidx_tape(int in_level, const char *in_js, size_t in_len, v2_tape_t *io_tape);
+void v2_tape_free(v2_tape_t *in_tape);
+
+// Length of tape scalar value at text in_js
+size_t v2_tape_len(const char *in_js, size_t in_len, uint64_t in_w);
+
+#endif // _V2_SIDX_H
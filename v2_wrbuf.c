@@ -21,7 +21,9 @@
 #include "v2_wrbuf.h"
 #include "v2_util.h"
 #include <sys/types.h>
+#include <sys/uio.h> // writev
 #include <unistd.h>
+#include <errno.h>
 
 /* ================================================================ */
 // Check if buffer ok and has data
@@ -87,6 +89,26 @@ int v2_wrbuf_seek(wrbuf_t *in_wrf, size_t in_position) {
     return(0);
 }
 /* ================================================================ */
+// Drop already used data - keeps buffer small when it is filled by chunks
+int v2_wrbuf_drop(wrbuf_t *in_wrf, size_t in_size) {
+
+    if(!in_wrf) return(14908);
+    if(!in_wrf->buf) return(0); // Nothing to drop
+
+    if(in_size > in_wrf->cnt) in_size=in_wrf->cnt;
+
+    if(in_size) {
+	memmove(in_wrf->buf, in_wrf->buf+in_size, in_wrf->cnt-in_size);
+	in_wrf->cnt -= in_size;
+	in_wrf->buf[in_wrf->cnt] = '\0';
+    }
+
+    in_wrf->pos = in_wrf->buf;
+    in_wrf->yet = in_wrf->cnt;
+
+    return(0);
+}
+/* ================================================================ */
 // Sets next string
 int v2_wrbuf_nxtstr(wrbuf_t *in_wrf) {
     char *pnt=NULL;
@@ -145,22 +167,7 @@ size_t v2_wrbuf_write(wrbuf_t *in_wrf, char *in_str, size_t in_size, size_t in_n
     if(!in_wrf)  return(-1);
     if(!in_str)  return(-1);
 
-    if(!in_wrf->sbl) in_wrf->sbl=V2_WRBUF_BLOCK;
-
-    if((in_wrf->cnt+cnt) >= in_wrf->siz) { // Have to rellocate buffer + place for '\0'
-	in_wrf->siz += cnt+in_wrf->sbl;
-	if(!(in_wrf->buf=(char *)realloc(in_wrf->buf, in_wrf->siz))) return(-1);
-    }
-
-    if(!memcpy(&in_wrf->buf[in_wrf->cnt], in_str, cnt)) return(-1);
-
-    in_wrf->cnt += cnt;
-    in_wrf->buf[in_wrf->cnt] = '\0';
-
-    in_wrf->pos = in_wrf->buf; // Have to set every time because buf can change
-    in_wrf->yet = in_wrf->cnt;
-
-    return(cnt); // Return number of stored bytes
+    return(v2_wrbuf_putn(in_wrf, in_str, cnt)); // Return number of stored bytes
 }
 /* ================================================================ */
 size_t v2_wrbuf_curl(char *in_str, size_t in_size, size_t in_num, void *userdata) {
@@ -194,6 +201,203 @@ int v2_wrbuf_printf(wrbuf_t *in_wrf, char *format, ...) {
     return(out);
 }
 /* ================================================================ */
+// Sinks
+/* ================================================================ */
+static size_t v2_wrbuf_fd_write(void *in_data, const char *in_buf, size_t in_len) {
+    wrbuf_t *wrf=(wrbuf_t *)in_data;
+    size_t out=0;
+    ssize_t rc=0;
+
+    while(out < in_len) {
+	if((rc=write(wrf->sfd, in_buf+out, in_len-out)) < 0) {
+	    if(errno == EINTR) continue;
+	    break;
+	}
+	out+=rc;
+    }
+    return(out);
+}
+/* ================================================================ */
+static size_t v2_wrbuf_file_write(void *in_data, const char *in_buf, size_t in_len) {
+
+    return(fwrite(in_buf, 1, in_len, (FILE *)in_data));
+}
+/* ================================================================ */
+// Buffered data and then in_str (can be NULL) go to sink, buffer is empty after
+static int v2_wrbuf_emit(wrbuf_t *in_wrf, const char *in_str, size_t in_len) {
+    struct iovec iov[2];
+    size_t all=in_wrf->cnt+in_len;
+    size_t out=0;
+    ssize_t rc=0;
+    int n=0;
+
+    if(in_wrf->serr) return(14940);
+    errno=0;
+
+    if(in_wrf->sink == v2_wrbuf_fd_write && in_wrf->cnt && in_len) { // Both by one call
+	iov[0].iov_base=in_wrf->buf;
+	iov[0].iov_len=in_wrf->cnt;
+	iov[1].iov_base=(void *)in_str;
+	iov[1].iov_len=in_len;
+	while(out < all) {
+	    if((rc=writev(in_wrf->sfd, iov+n, 2-n)) < 0) {
+		if(errno == EINTR) continue;
+		break;
+	    }
+	    out+=rc;
+	    for(; n < 2 && (size_t)rc >= iov[n].iov_len; n++) rc-=iov[n].iov_len; // Partial write - rest of vectors
+	    if(n < 2) {
+		iov[n].iov_base=(char *)iov[n].iov_base+rc;
+		iov[n].iov_len-=rc;
+	    }
+	}
+    } else {
+	if(in_wrf->cnt) out+=in_wrf->sink(in_wrf->sdata, in_wrf->buf, in_wrf->cnt);
+	if(in_len && out == in_wrf->cnt) out+=in_wrf->sink(in_wrf->sdata, in_str, in_len);
+    }
+
+    in_wrf->sout+=out;
+    if(out != all) in_wrf->serr=errno?errno:EIO;
+
+    in_wrf->cnt=0; // Empty anyway - failed data is dropped
+    if(in_wrf->buf) in_wrf->buf[0]='\0';
+    in_wrf->pos=in_wrf->buf;
+    in_wrf->yet=0;
+
+    return(in_wrf->serr?14940:0);
+}
+/* ================================================================ */
+int v2_wrbuf_sink(wrbuf_t *in_wrf, size_t (*in_sink)(void *, const char *, size_t), void *in_data, size_t in_flush) {
+
+    if(!in_wrf) return(14941);
+
+    in_wrf->sink  = in_sink;
+    in_wrf->sdata = in_data;
+    in_wrf->sfl   = in_flush?in_flush:V2_WRBUF_BLOCK;
+    in_wrf->serr  = 0;
+    in_wrf->sout  = 0;
+
+    return(0);
+}
+/* ================================================================ */
+int v2_wrbuf_sink_fd(wrbuf_t *in_wrf, int in_fd, size_t in_flush) {
+
+    if(!in_wrf || in_fd < 0) return(14941);
+
+    in_wrf->sfd=in_fd;
+    return(v2_wrbuf_sink(in_wrf, v2_wrbuf_fd_write, in_wrf, in_flush));
+}
+/* ================================================================ */
+int v2_wrbuf_sink_file(wrbuf_t *in_wrf, FILE *in_file, size_t in_flush) {
+
+    if(!in_file) return(14941);
+
+    return(v2_wrbuf_sink(in_wrf, v2_wrbuf_file_write, in_file, in_flush));
+}
+/* ================================================================ */
+int v2_wrbuf_flush(wrbuf_t *in_wrf) {
+
+    if(!in_wrf)       return(14941);
+    if(!in_wrf->sink) return(0); // Data stays at buffer
+
+    return(v2_wrbuf_emit(in_wrf, NULL, 0));
+}
+/* ================================================================ */
+// Direct writes: room is reserved first, then bytes are put right after cnt
+/* ================================================================ */
+char *v2_wrbuf_room(wrbuf_t *in_wrf, size_t in_size) {
+    char *buf=NULL;
+
+    if(!in_wrf) return(NULL);
+
+    if(in_wrf->sink) {
+	if(in_wrf->serr) return(NULL); // Nowhere to go
+	if(in_wrf->cnt && in_wrf->cnt+in_size > in_wrf->sfl && v2_wrbuf_flush(in_wrf)) return(NULL);
+    }
+
+    if(!in_wrf->sbl) in_wrf->sbl=V2_WRBUF_BLOCK;
+
+    if(!in_wrf->buf || (in_wrf->cnt+in_size) >= in_wrf->siz) { // Same as v2_wrbuf_write() - place for '\0' too
+	if(!(buf=(char *)realloc(in_wrf->buf, in_wrf->siz+in_size+in_wrf->sbl))) return(NULL);
+	in_wrf->buf=buf;
+	in_wrf->siz+=in_size+in_wrf->sbl;
+	in_wrf->pos=in_wrf->buf;
+    }
+
+    return(in_wrf->buf+in_wrf->cnt);
+}
+/* ================================================================ */
+// in_size bytes are put at room - move the end
+size_t v2_wrbuf_used(wrbuf_t *in_wrf, size_t in_size) {
+
+    in_wrf->cnt += in_size;
+    in_wrf->buf[in_wrf->cnt] = '\0';
+
+    in_wrf->pos = in_wrf->buf;
+    in_wrf->yet = in_wrf->cnt;
+
+    return(in_size);
+}
+/* ================================================================ */
+size_t v2_wrbuf_putc(wrbuf_t *in_wrf, char in_chr) {
+    char *out=NULL;
+
+    if(!(out=v2_wrbuf_room(in_wrf, 1))) return(-1);
+
+    *out=in_chr;
+    return(v2_wrbuf_used(in_wrf, 1));
+}
+/* ================================================================ */
+size_t v2_wrbuf_putn(wrbuf_t *in_wrf, const char *in_str, size_t in_len) {
+    char *out=NULL;
+
+    if(!in_str) return(-1);
+    if(!in_len) return(0);
+
+    if(in_wrf && in_wrf->sink && in_len >= in_wrf->sfl) { // Big one goes out as is, after buffered data
+	if(v2_wrbuf_emit(in_wrf, in_str, in_len)) return(-1);
+	return(in_len);
+    }
+
+    if(!(out=v2_wrbuf_room(in_wrf, in_len))) return(-1);
+
+    memcpy(out, in_str, in_len);
+    return(v2_wrbuf_used(in_wrf, in_len));
+}
+/* ================================================================ */
+size_t v2_wrbuf_puts(wrbuf_t *in_wrf, const char *in_str) {
+
+    if(!in_str) return(-1);
+
+    return(v2_wrbuf_putn(in_wrf, in_str, strlen(in_str)));
+}
+/* ================================================================ */
+size_t v2_wrbuf_put_i64(wrbuf_t *in_wrf, long long in_num) {
+    char tmp[24];
+    char *dig=tmp+sizeof(tmp);
+    unsigned long long num=in_num<0?0ULL-(unsigned long long)in_num:(unsigned long long)in_num; // LLONG_MIN too
+
+    do { // Digits from the end
+	*--dig='0'+(char)(num%10);
+	num/=10;
+    } while(num);
+
+    if(in_num<0) *--dig='-';
+
+    return(v2_wrbuf_putn(in_wrf, dig, tmp+sizeof(tmp)-dig));
+}
+/* ================================================================ */
+size_t v2_wrbuf_put_spaces(wrbuf_t *in_wrf, size_t in_num) {
+    char *out=NULL;
+
+    if(!in_num) return(0);
+
+    if(!(out=v2_wrbuf_room(in_wrf, in_num))) return(-1);
+
+    memset(out, ' ', in_num);
+    return(v2_wrbuf_used(in_wrf, in_num));
+}
+/* ================================================================ */
 int v2_wrbuf_file_read(wrbuf_t *in_wrf, char *file, ...) {
     va_list vl;
     FILE *cf=stdin;
@@ -43,6 +43,14 @@ typedef struct {
 
     size_t sbl; // Size of block for allocation, most time == V2_WRBUF_BLOCK
 
+    // Sink - buffer is emptied to it when data gets over sfl bytes, set by v2_wrbuf_sink*()
+    size_t (*sink)(void *in_data, const char *in_buf, size_t in_len); // Returns written bytes, less - error
+    void *sdata; // Sink data
+    int sfd;     // File descriptor of v2_wrbuf_sink_fd()
+    int serr;    // Sink failed - errno, data is dropped since
+    size_t sfl;  // Flush threshold
+    size_t sout; // Bytes gone to sink
+
 } wrbuf_t;
 
 // Check if buffer ok and has data - if OK == 0
@@ -55,6 +63,9 @@ int v2_wrbuf_reset(wrbuf_t *in_wrf);
 int v2_wrbuf_free(wrbuf_t **in_wrf);
 int v2_wrbuf_seek(wrbuf_t *in_wrf, size_t position);
 
+// Remove in_size bytes from the buffer beginning, rest moves to start
+int v2_wrbuf_drop(wrbuf_t *in_wrf, size_t in_size);
+
 // Service function - get string from the buffer
 int v2_wrbuf_nxtstr(wrbuf_t *in_wrf);
 
@@ -67,6 +78,23 @@ size_t v2_wrbuf_curl(char *in_str, size_t in_size, size_t in_num, void *userdata
 // Print string to to buffer
 int v2_wrbuf_printf(wrbuf_t *in_wrf, char *format, ...);
 
+// Direct writes into reserved buffer space - no format parsing, no length limit
+// Return number of stored bytes or -1 like v2_wrbuf_write()
+char  *v2_wrbuf_room(wrbuf_t *in_wrf, size_t in_size); // Makes place for in_size bytes + '\0' after cnt, NULL if no memory
+size_t v2_wrbuf_used(wrbuf_t *in_wrf, size_t in_size); // in_size bytes put at room are added to buffer
+size_t v2_wrbuf_putc(wrbuf_t *in_wrf, char in_chr);
+size_t v2_wrbuf_puts(wrbuf_t *in_wrf, const char *in_str);
+size_t v2_wrbuf_putn(wrbuf_t *in_wrf, const char *in_str, size_t in_len);
+size_t v2_wrbuf_put_i64(wrbuf_t *in_wrf, long long in_num);   // As "%lld"
+size_t v2_wrbuf_put_spaces(wrbuf_t *in_wrf, size_t in_num);   // As "%*c" with ' '
+
+// Streaming: written data goes to sink by in_flush bytes (0 - V2_WRBUF_BLOCK), buffer keeps the rest only
+// Set after v2_wrbuf_new()/v2_wrbuf_reset() - they forget sink. Last part goes out by v2_wrbuf_flush()
+int v2_wrbuf_sink(wrbuf_t *in_wrf, size_t (*in_sink)(void *, const char *, size_t), void *in_data, size_t in_flush);
+int v2_wrbuf_sink_fd(wrbuf_t *in_wrf, int in_fd, size_t in_flush);       // write()/writev()
+int v2_wrbuf_sink_file(wrbuf_t *in_wrf, FILE *in_file, size_t in_flush); // fwrite()
+int v2_wrbuf_flush(wrbuf_t *in_wrf); // 14940 if sink failed (errno is in serr)
+
 // Read file to wrbuf
 int v2_wrbuf_file_read(wrbuf_t *in_wrf, char *file, ...);
 